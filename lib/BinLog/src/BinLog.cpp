@@ -0,0 +1,90 @@
+#include "BinLog.h"
+
+#include <ESP8266WiFi.h>
+
+/** Masking every interrupt level is the shortest critical section an ISR writer can be excluded with */
+static uint32_t IRAM_ATTR maskInterrupts() {
+    return xt_rsil(15);
+}
+
+static void IRAM_ATTR restoreInterrupts(uint32_t saved_ps) {
+    xt_wsr_ps(saved_ps);
+}
+
+BinLogClass::BinLogClass()
+    : _ring(_buffer, BINLOG_BUFFER_WORDS, micros, maskInterrupts, restoreInterrupts)
+    , _dropped_reported(0)
+    , _sink(SINK_NONE)
+    , _serial(nullptr)
+    , _udp_host(nullptr)
+    , _udp_port(0) {
+}
+
+void BinLogClass::beginSerial(Stream &serial) {
+    _serial = &serial;
+    _sink   = SINK_SERIAL;
+}
+
+void BinLogClass::beginUdp(const char *host, uint16_t port) {
+    _udp_host = host;
+    _udp_port = port;
+    _sink     = SINK_UDP;
+}
+
+void BinLogClass::handle() {
+    uint32_t dropped = _ring.getDropped();
+    if (dropped != _dropped_reported) {
+        _dropped_reported = dropped;
+        BLOG("binlog: %u records dropped", dropped);
+    }
+
+    switch (_sink) {
+        case SINK_SERIAL:
+            drainSerial();
+            break;
+        case SINK_UDP:
+            drainUdp();
+            break;
+        case SINK_NONE:
+        default:
+            break;
+    }
+}
+
+uint32_t BinLogClass::getDropped() {
+    return _ring.getDropped();
+}
+
+void BinLogClass::drainSerial() {
+    uint8_t frame[MAX_FRAME_SIZE];
+
+    // only what fits in the TX FIFO, the logger never waits on the UART
+    for (uint8_t words = _ring.peek(); words > 0; words = _ring.peek()) {
+        if (static_cast<size_t>(_serial->availableForWrite()) < 2 + words * 4U) {
+            return;
+        }
+
+        size_t size = _ring.pop(frame);
+        _serial->write(frame, size);
+    }
+}
+
+void BinLogClass::drainUdp() {
+    if (_ring.peek() == 0 || WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+
+    uint8_t frame[MAX_FRAME_SIZE];
+    size_t payload = 0;
+
+    // a single datagram per call, several records each
+    _udp.beginPacket(_udp_host, _udp_port);
+    for (uint8_t words = _ring.peek(); words > 0 && payload + 2 + words * 4U <= UDP_PAYLOAD; words = _ring.peek()) {
+        size_t size = _ring.pop(frame);
+        _udp.write(frame, size);
+        payload += size;
+    }
+    _udp.endPacket();
+}
+
+BinLogClass BinLog;
@@ -0,0 +1,114 @@
+#ifndef KF_BINLOG_H
+#define KF_BINLOG_H
+
+#include <Arduino.h>
+#include <LogRing.hpp>
+#include <WiFiUdp.h>
+
+/** Ring buffer size in 4 bytes words, must be a power of two */
+#ifndef BINLOG_BUFFER_WORDS
+#define BINLOG_BUFFER_WORDS 512
+#endif
+
+/** Arguments a single log point may carry */
+#define BINLOG_MAX_ARGS 8
+
+/**
+ * Log a format string and its arguments as a binary record.
+ *
+ * Only the flash address of the format string and the raw 32 bits arguments are
+ * stored, the text is rebuilt on the host by `tools/binlog_decode.py` from the ELF.
+ * Integers, bools, enums and floats are supported, pointers and `%s` are not.
+ *
+ *    BLOG("fan speed %u -> %u", previous, speed);
+ */
+#define BLOG(fmt, ...) BinLog.log(PSTR(fmt), ##__VA_ARGS__)
+
+/**
+ * Binary Logger
+ *
+ * Log points cost a few microseconds: an interrupt masked index bump and
+ * a handful of word stores. The buffer is drained over Serial or UDP from loop().
+ * It is safe to log from an ISR, the writer is fully in IRAM.
+ *
+ * inside your setup()
+ *    BinLog.beginSerial(Serial)
+ *
+ * inside your loop()
+ *    BinLog.handle()
+ *
+ * Records and frames on the wire are laid out by `LogRing`.
+ */
+class BinLogClass {
+ public:
+    static const uint8_t MAX_FRAME_SIZE = 2 + (LogRing::RECORD_WORDS + BINLOG_MAX_ARGS) * 4;
+
+ private:
+    static_assert((BINLOG_BUFFER_WORDS & (BINLOG_BUFFER_WORDS - 1)) == 0, "BINLOG_BUFFER_WORDS must be a power of two");
+
+    enum Sink : uint8_t {
+        SINK_NONE = 0,
+        SINK_SERIAL,
+        SINK_UDP
+    };
+
+    volatile uint32_t _buffer[BINLOG_BUFFER_WORDS];
+    LogRing _ring;
+    uint32_t _dropped_reported;
+
+    Sink _sink;
+    Stream *_serial;
+    WiFiUDP _udp;
+    const char *_udp_host;
+    uint16_t _udp_port;
+    /** Keep datagrams under the smallest MTU */
+    const size_t UDP_PAYLOAD = 512;
+
+ public:
+    BinLogClass();
+
+    /** Drain records into a serial port that is already started */
+    void beginSerial(Stream &serial);
+
+    /** Drain records as UDP datagrams once WiFi is connected */
+    void beginUdp(const char *host, uint16_t port);
+
+    /** Send the pending records without blocking */
+    void handle();
+
+    /** Records lost because the buffer was full */
+    uint32_t getDropped();
+
+    /** Use the `BLOG()` macro, the format string has to live in flash */
+    template<typename... Args>
+    inline __attribute__((always_inline)) void log(const char *fmt, Args... args) {
+        static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many arguments for a log point");
+
+        const uint32_t words[sizeof...(Args) + 1] = {pack(args)..., 0};
+        _ring.push(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt)), words, sizeof...(Args));
+    }
+
+ private:
+    void drainSerial();
+    void drainUdp();
+
+    static inline __attribute__((always_inline)) uint32_t pack(float value) {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+
+    static inline __attribute__((always_inline)) uint32_t pack(double value) {
+        return pack(static_cast<float>(value));
+    }
+
+    template<typename T>
+    static inline __attribute__((always_inline)) uint32_t pack(T value) {
+        return static_cast<uint32_t>(value);
+    }
+};
+
+/** Binary logger drained over Serial or UDP */
+extern BinLogClass BinLog;
+
+#endif    // KF_BINLOG_H
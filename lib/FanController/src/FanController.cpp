@@ -79,15 +79,18 @@ void FanController::setDesiredTemperatureThreshold(int8_t desired_temp_threshold
 }
 
 uint8_t FanController::getFanSpeedIndicator() {
-    switch (_latest_fan_speed) {
-        case FanSpeed::FAN_LOW:
-            return 0;
-        case FanSpeed::FAN_NORMAL:
-            return 1;
-        case FanSpeed::FAN_HIGH:
-            return 2;
-        default:
-            return 3;
+    return toFanSpeedIndicator(_latest_fan_speed);
+}
+
+uint8_t FanController::toFanSpeedIndicator(uint16_t fan_speed) {
+    if (fan_speed == FanSpeed::FAN_OFF) {
+        return 3;
+    } else if (fan_speed <= FanSpeed::FAN_LOW) {
+        return 0;
+    } else if (fan_speed <= FanSpeed::FAN_NORMAL) {
+        return 1;
+    } else {
+        return 2;
     }
 }
 
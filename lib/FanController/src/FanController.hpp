@@ -84,6 +84,16 @@ class FanController {
      */
     uint8_t getFanSpeedIndicator();
 
+    /**
+     * Get the fan speed index of any duty, e.g. a fail-safe duty applied outside the controller.
+     * A duty between two speeds belongs to the higher one.
+     *
+     * @param fan_speed Duty written to the fan
+     *
+     * @return uint8_t Same index as `getFanSpeedIndicator()`
+     */
+    static uint8_t toFanSpeedIndicator(uint16_t fan_speed);
+
     /**
      * Check whether fan active or turned off
      *
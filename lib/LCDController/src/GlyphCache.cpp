@@ -0,0 +1,92 @@
+#include "GlyphCache.hpp"
+
+static const char GLYPH_BYTES[GLYPH_COUNT][8] PROGMEM = {
+   {0x01, 0x02, 0x1E, 0x02, 0x0E, 0x02, 0x06, 0x02},    // logo
+   {0x10, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08},
+   {0x02, 0x03, 0x07, 0x0F, 0x0F, 0x0F, 0x0F, 0x07},
+   {0x08, 0x18, 0x1C, 0x1E, 0x1E, 0x1E, 0x1E, 0x1C},
+   {0x04, 0x0A, 0x0A, 0x0A, 0x0E, 0x1F, 0x1F, 0x0E},    // temp
+   {0x07, 0x05, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00},    // deg
+   {0x00, 0x0C, 0x05, 0x17, 0x1C, 0x04, 0x06, 0x00},    // fan
+   {0x00, 0x0E, 0x11, 0x15, 0x11, 0x0E, 0x00, 0x00},    // target
+   {0x00, 0x15, 0x0E, 0x1F, 0x0E, 0x15, 0x00, 0x00},    // sun
+   {0x0E, 0x0E, 0x04, 0x1F, 0x04, 0x0A, 0x11, 0x00},    // person
+   {0x00, 0x0E, 0x11, 0x04, 0x0A, 0x00, 0x04, 0x00},    // wifi
+   {0x00, 0x0C, 0x12, 0x13, 0x1D, 0x11, 0x0E, 0x00},    // cloud
+   {0x00, 0x0E, 0x15, 0x17, 0x11, 0x0E, 0x00, 0x00},    // clock
+};
+
+GlyphCache::GlyphCache(LiquidCrystal_I2C &lcd)
+    : _lcd(lcd)
+    , _clock(0) {
+    reset();
+}
+
+void GlyphCache::reset() {
+    for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+        _slot_glyph[i] = GLYPH_COUNT;
+        _slot_used[i]  = 0;
+    }
+    _clock = 0;
+}
+
+uint8_t GlyphCache::slotOf(uint8_t glyph) {
+    for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+        if (_slot_glyph[i] == glyph) {
+            return i;
+        }
+    }
+
+    return NO_SLOT;
+}
+
+void GlyphCache::touch(uint8_t glyph) {
+    uint8_t slot = slotOf(glyph);
+    if (slot == NO_SLOT) {
+        return;
+    }
+
+    // on overflow restart every stamp, the order is lost only once per 65k uses
+    if (++_clock == 0) {
+        for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+            _slot_used[i] = 0;
+        }
+        _clock = 1;
+    }
+    _slot_used[slot] = _clock;
+}
+
+uint8_t GlyphCache::load(uint8_t glyph, uint8_t pinned_slots) {
+    if (glyph >= GLYPH_COUNT) {
+        return NO_SLOT;
+    }
+
+    uint8_t slot = slotOf(glyph);
+    if (slot != NO_SLOT) {
+        touch(glyph);
+        return slot;
+    }
+
+    // empty slots have a zero stamp, so they are picked first
+    for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+        if (pinned_slots & (1 << i)) {
+            continue;
+        }
+        if (slot == NO_SLOT || _slot_used[i] < _slot_used[slot]) {
+            slot = i;
+        }
+    }
+
+    if (slot == NO_SLOT) {
+        return NO_SLOT;
+    }
+
+    char bytes[8];
+    memcpy_P(bytes, GLYPH_BYTES[glyph], sizeof(bytes));
+    _lcd.createChar(slot, bytes);
+
+    _slot_glyph[slot] = glyph;
+    touch(glyph);
+
+    return slot;
+}
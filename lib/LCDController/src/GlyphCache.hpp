@@ -0,0 +1,81 @@
+#ifndef KF_GLYPHCACHE_HPP
+#define KF_GLYPHCACHE_HPP
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+
+/**
+ * Custom characters known by the display, the bitmaps live in flash.
+ */
+enum Glyph : uint8_t {
+    GLYPH_LOGO_TL = 0,
+    GLYPH_LOGO_TR,
+    GLYPH_LOGO_BL,
+    GLYPH_LOGO_BR,
+    GLYPH_TEMP,
+    GLYPH_DEG,
+    GLYPH_FAN,
+    GLYPH_TARGET,
+    GLYPH_SUN,
+    GLYPH_PERSON,
+    GLYPH_WIFI,
+    GLYPH_CLOUD,
+    GLYPH_CLOCK,
+    GLYPH_COUNT
+};
+
+/**
+ * Glyph Cache
+ *
+ * HD44780 only has 8 CGRAM slots while the pages need more glyphs than that.
+ * The cache uploads a glyph only when it is not resident and evicts the least
+ * recently used slot that is neither visible nor needed by the next frame.
+ */
+class GlyphCache {
+ public:
+    static const uint8_t SLOT_COUNT = 8;
+    static const uint8_t NO_SLOT    = 0xFF;
+
+ private:
+    LiquidCrystal_I2C &_lcd;
+
+    /** Glyph held by each slot, `GLYPH_COUNT` when empty */
+    uint8_t _slot_glyph[SLOT_COUNT];
+    /** Last use of each slot, lower is older */
+    uint16_t _slot_used[SLOT_COUNT];
+    uint16_t _clock;
+
+ public:
+    explicit GlyphCache(LiquidCrystal_I2C &lcd);
+
+    /** Copy constructor is not allowed here */
+    GlyphCache(const GlyphCache &) = delete;
+
+    /** Forget every slot, the CGRAM content is unknown (e.g. after `init()`) */
+    void reset();
+
+    /**
+     * Look up the slot holding a glyph
+     *
+     * @return uint8_t slot index or `NO_SLOT`
+     */
+    uint8_t slotOf(uint8_t glyph);
+
+    /** Mark a resident glyph as recently used */
+    void touch(uint8_t glyph);
+
+    /**
+     * Upload a glyph into the least recently used free slot.
+     *
+     * It moves the LCD address counter into CGRAM, the caller must set the
+     * cursor again before printing.
+     *
+     * @param glyph Glyph to upload
+     * @param pinned_slots Bitmask of slots that must not be evicted
+     *
+     * @return uint8_t slot index or `NO_SLOT` when every slot is pinned
+     */
+    uint8_t load(uint8_t glyph, uint8_t pinned_slots);
+};
+
+#endif    // KF_GLYPHCACHE_HPP
@@ -1,58 +1,88 @@
 #include "LCDController.hpp"
 
 LCDController::LCDController()
-    : _lcd(0x27, 16, 2)
+    : _lcd(0x27, COLS, ROWS)
+    , _glyphs(_lcd)
     , _initialized(false)
     , _is_backlight_on(true)
-    , _latest_update(0)
-    , _temperature_counter(0)
-    , _fan_speed_counter(1 << 7) {
+    , _is_backlight_lit(true)
+    , _cursor_col(COLS)
+    , _cursor_row(0)
+    , _is_flushing(false)
+    , _policy(millis)
+    , _page(PAGE_HOME)
+    , _backlight_pin(-1)
+    , _ambient_precentage(0)
+    , _backlight_level(0) {
 }
 
-void LCDController::begin() {
+void LCDController::begin(int8_t backlight_pin) {
     if (_initialized) {
         return;
     }
 
+    _backlight_pin = backlight_pin;
+    if (_backlight_pin >= 0) {
+        pinMode(_backlight_pin, OUTPUT);
+        analogWrite(_backlight_pin, _is_backlight_on ? BACKLIGHT_MAX_DUTY : 0);
+    }
+
     // init lcd
     _lcd.init();
     _lcd.setBacklight(_is_backlight_on);
+    _is_backlight_lit = _is_backlight_on;
     _lcd.clear();
 
-    // load and render custom chars for the initializations
-    for (uint8_t i = 0; i < _custom_chars.sizes; ++i) {
-        const char* chr = _custom_chars.char_bytes[i];
-        uint8_t col     = _custom_chars.char_pos[i][0];
-        uint8_t row     = _custom_chars.char_pos[i][1];
-
-        _lcd.createChar(i, chr);
-        _lcd.setCursor(col, row);
-        _lcd.write(i);
-    }
+    // cleared screen, empty CGRAM, glyphs are uploaded once a page needs them
+    memset(_front, ' ', sizeof(_front));
+    _glyphs.reset();
+    _cursor_col = COLS;
 
-    _lcd.setCursor(12, 0);
-    _lcd.print(F("c"));
+    _policy.begin();
 
     _initialized = true;
 }
 
-void LCDController::update(float temperature, uint8_t fan_speed) {
-    unsigned long current_millis = millis();
+void LCDController::update(const LCDData &data) {
+    if (!_initialized) {
+        return;
+    }
+
+    _ambient_precentage = min<uint8_t>(data.ldr_precentage, 100);
+    applyBacklight(_policy.updatePresence(_is_backlight_on, data.has_living_object));
+
+    // nothing is visible, keep the i2c bus idle
+    if (!_is_backlight_lit) {
+        return;
+    }
+
+    if (_policy.isPageDue()) {
+        _page = (_page + 1) % PAGE_COUNT;
+    }
+
+    // finish the pending frame before composing a new one
+    if (_is_flushing) {
+        _is_flushing = !flush(FLUSH_BUDGET);
+        return;
+    }
 
-    if (((_latest_update - current_millis) < SCREEN_UPDATE_TIME) || !_initialized) {
+    if (!_policy.isComposeDue()) {
         return;
     }
 
-    if (!_is_backlight_on) {
-        _latest_update = current_millis;
+    composePage(data);
+
+    RefreshPolicy::Action action = _policy.commit(memcmp(_front, _back, sizeof(_front)) != 0);
+    if (action == RefreshPolicy::ACTION_NONE) {
         return;
     }
 
-    _latest_update = current_millis;
+    if (action == RefreshPolicy::ACTION_REPAINT) {
+        // nothing changed for a while, rewrite every cell in case the screen got corrupted
+        memset(_front, CELL_UNKNOWN, sizeof(_front));
+    }
 
-    // update dynamic data with newest data
-    loadTemperature(temperature);
-    loadFanSpeed(fan_speed);
+    _is_flushing = !flush(FLUSH_BUDGET);
 }
 
 bool LCDController::isBacklightOn() {
@@ -61,54 +91,257 @@ bool LCDController::isBacklightOn() {
 
 void LCDController::setBlacklightOn(bool is_on) {
     _is_backlight_on = is_on;
-    _lcd.setBacklight(is_on);
+
+    if (_initialized) {
+        applyBacklight(_is_backlight_on && _policy.isOccupied());
+    }
 }
 
-void LCDController::loadFanSpeed(uint8_t fan_speed) {
-    if (fan_speed == _fan_speed_counter) {
+void LCDController::applyBacklight(bool is_lit) {
+    if (is_lit != _is_backlight_lit) {
+        _is_backlight_lit = is_lit;
+        _lcd.setBacklight(is_lit);
+    }
+
+    if (_backlight_pin < 0) {
+        return;
+    }
+
+    // darker room, dimmer backlight
+    uint8_t level = is_lit ? 1 + (_ambient_precentage * (BACKLIGHT_LEVELS - 1)) / 100 : 0;
+    if (level == _backlight_level) {
         return;
     }
-    _fan_speed_counter = fan_speed;
+    _backlight_level = level;
+
+    uint16_t duty = 0;
+    if (level > 0) {
+        duty = BACKLIGHT_MIN_DUTY + ((BACKLIGHT_MAX_DUTY - BACKLIGHT_MIN_DUTY) * (level - 1)) / (BACKLIGHT_LEVELS - 1);
+    }
+    analogWrite(_backlight_pin, duty);
+}
+
+void LCDController::composePage(const LCDData &data) {
+    memset(_back, ' ', sizeof(_back));
+
+    char buf[COLS + 1];
+    int len;
+    unsigned long uptime_s;
+
+    switch (_page) {
+        case PAGE_SETPOINT:
+            putGlyph(0, 0, GLYPH_TARGET);
+            putText(2, 0, "Target");
+            snprintf(buf, sizeof(buf), "%3d", data.desired_temp_c);
+            putText(10, 0, buf);
+            putGlyph(13, 0, GLYPH_DEG);
+            putText(14, 0, "c");
+
+            putText(2, 1, "Range");
+            len = snprintf(buf, sizeof(buf), "%d-%d", data.desired_temp_c - data.desired_temp_threshold_c, data.desired_temp_c + data.desired_temp_threshold_c);
+            putText(13 - len, 1, buf);
+            putGlyph(13, 1, GLYPH_DEG);
+            putText(14, 1, "c");
+            break;
+
+        case PAGE_LIGHT:
+            putGlyph(0, 0, GLYPH_SUN);
+            putText(2, 0, "Light");
+            snprintf(buf, sizeof(buf), "%3u%%", static_cast<unsigned>(data.ldr_precentage));
+            putText(11, 0, buf);
+
+            // 10 cells bar, it only moves every 10%
+            putText(2, 1, "[");
+            for (uint8_t i = 0; i < 10; ++i) {
+                buf[i] = i < data.ldr_precentage / 10 ? '#' : '-';
+            }
+            buf[10] = '\0';
+            putText(3, 1, buf);
+            putText(13, 1, "]");
+            break;
+
+        case PAGE_ROOM:
+            putGlyph(0, 0, GLYPH_PERSON);
+            putText(2, 0, "Room");
+            putText(10, 0, data.has_living_object ? "motion" : "still");
+
+            // the screen is only lit while the room is occupied, show for how long
+            snprintf(buf, sizeof(buf), "occupied %lum", _policy.getOccupiedTime() / 60000UL);
+            putText(2, 1, buf);
+            break;
 
-    // max 6 bytes
-    for (uint8_t i = 7; i <= 13; ++i) {
-        _lcd.setCursor(i, 1);
-        _lcd.print(" ");
+        case PAGE_NETWORK:
+            putGlyph(0, 0, GLYPH_WIFI);
+            putText(2, 0, "WiFi");
+            putText(9, 0, data.is_wifi_connected ? "online" : "offline");
+
+            putGlyph(0, 1, GLYPH_CLOUD);
+            putText(2, 1, "Cloud");
+            putText(9, 1, data.is_cloud_connected ? "online" : "offline");
+            break;
+
+        case PAGE_UPTIME:
+            putGlyph(0, 0, GLYPH_CLOCK);
+            putText(2, 0, "Uptime");
+            uptime_s = _policy.getUptime();
+            snprintf(buf, sizeof(buf), "%lud %02lu:%02lu:%02lu", uptime_s / 86400UL, (uptime_s / 3600UL) % 24, (uptime_s / 60UL) % 60, uptime_s % 60);
+            putText(2, 1, buf);
+            break;
+
+        case PAGE_HOME:
+        default:
+            putGlyph(0, 0, GLYPH_LOGO_TL);
+            putGlyph(1, 0, GLYPH_LOGO_TR);
+            putGlyph(0, 1, GLYPH_LOGO_BL);
+            putGlyph(1, 1, GLYPH_LOGO_BR);
+
+            putGlyph(5, 0, GLYPH_TEMP);
+            if (data.is_fail_safe) {
+                // the reading is stale, the fan below runs on its safe duty
+                putText(7, 0, "lost");
+            } else {
+                composeTemperature(7, 0, data.temperature_c);
+                putGlyph(11, 0, GLYPH_DEG);
+                putText(12, 0, "c");
+            }
+
+            putGlyph(5, 1, GLYPH_FAN);
+            composeFanSpeed(7, 1, data.fan_speed);
+            break;
     }
+}
 
-    _lcd.setCursor(7, 1);
+void LCDController::composeFanSpeed(uint8_t col, uint8_t row, uint8_t fan_speed) {
     switch (fan_speed) {
         case 0:
-            _lcd.print(F("low"));
+            putText(col, row, "low");
             break;
         case 1:
-            _lcd.print(F("normal"));
+            putText(col, row, "normal");
             break;
         case 2:
-            _lcd.print(F("high"));
+            putText(col, row, "high");
             break;
         case 3:
         default:
-            _lcd.print(F("off"));
+            putText(col, row, "off");
             break;
     }
 }
 
-void LCDController::loadTemperature(float temperature) {
-    int16_t casted_temp = static_cast<int16_t>(temperature);
-    if (casted_temp == _temperature_counter) {
-        return;
-    }
-    _temperature_counter = casted_temp;
+void LCDController::composeTemperature(uint8_t col, uint8_t row, float temperature) {
+    int16_t degree = _policy.displayTemperature(temperature);
 
     // max 4 bytes
-    for (uint8_t i = 7; i <= 10; ++i) {
-        _lcd.setCursor(i, 0);
-        _lcd.print(" ");
+    char buf[5];
+    const char *fmt = degree < 0 ? "-%d" : " %d";
+    snprintf(buf, sizeof(buf), fmt, abs(degree));
+
+    putText(col, row, buf);
+}
+
+void LCDController::putText(uint8_t col, uint8_t row, const char *text) {
+    for (; *text != '\0' && col < COLS; ++text, ++col) {
+        _back[row][col] = static_cast<uint8_t>(*text);
+    }
+}
+
+void LCDController::putGlyph(uint8_t col, uint8_t row, uint8_t glyph) {
+    _back[row][col] = CELL_GLYPH | glyph;
+    _glyphs.touch(glyph);
+}
+
+bool LCDController::flush(uint8_t budget) {
+    // first pass: text and resident glyphs. A visible glyph that is replaced by a
+    // glyph still waiting for its upload is blanked, so its slot can be reused unseen.
+    for (uint8_t row = 0; row < ROWS; ++row) {
+        for (uint8_t col = 0; col < COLS; ++col) {
+            uint8_t cell = _back[row][col];
+            if (cell == _front[row][col]) {
+                continue;
+            }
+
+            uint8_t slot = 0;
+            if (cell & CELL_GLYPH) {
+                slot = _glyphs.slotOf(cell & ~CELL_GLYPH);
+
+                if (slot == GlyphCache::NO_SLOT) {
+                    if (!(_front[row][col] & CELL_GLYPH)) {
+                        continue;
+                    }
+                    cell = ' ';
+                }
+            }
+
+            writeCell(col, row, cell, slot);
+            if (--budget == 0) {
+                return false;
+            }
+        }
+    }
+
+    // second pass: upload the missing glyphs, nothing visible uses the evicted slots
+    for (uint8_t row = 0; row < ROWS; ++row) {
+        for (uint8_t col = 0; col < COLS; ++col) {
+            uint8_t cell = _back[row][col];
+            if (cell == _front[row][col]) {
+                continue;
+            }
+
+            uint8_t glyph = cell & ~CELL_GLYPH;
+            uint8_t slot  = _glyphs.slotOf(glyph);
+            if (slot == GlyphCache::NO_SLOT) {
+                slot        = _glyphs.load(glyph, usedSlots());
+                _cursor_col = COLS;
+            }
+
+            // a page never needs more glyphs than the CGRAM holds
+            if (slot == GlyphCache::NO_SLOT) {
+                continue;
+            }
+
+            writeCell(col, row, cell, slot);
+            if (--budget == 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+uint8_t LCDController::usedSlots() {
+    uint8_t slots = 0;
+
+    for (uint8_t row = 0; row < ROWS; ++row) {
+        for (uint8_t col = 0; col < COLS; ++col) {
+            const uint8_t cells[2] = {_front[row][col], _back[row][col]};
+
+            for (uint8_t cell : cells) {
+                if (!(cell & CELL_GLYPH)) {
+                    continue;
+                }
+
+                uint8_t slot = _glyphs.slotOf(cell & ~CELL_GLYPH);
+                if (slot != GlyphCache::NO_SLOT) {
+                    slots |= 1 << slot;
+                }
+            }
+        }
+    }
+
+    return slots;
+}
+
+void LCDController::writeCell(uint8_t col, uint8_t row, uint8_t cell, uint8_t slot) {
+    if (col != _cursor_col || row != _cursor_row) {
+        _lcd.setCursor(col, row);
     }
 
-    const char* fmt = casted_temp < 0 ? "-%d" : " %d";
+    _lcd.write((cell & CELL_GLYPH) ? slot : cell);
+    _front[row][col] = cell;
 
-    _lcd.setCursor(7, 0);
-    _lcd.printf(fmt, abs(casted_temp));
+    // address counter does not continue on the next row, `COLS` marks it unknown
+    _cursor_col = col + 1;
+    _cursor_row = row;
 }
@@ -4,23 +4,31 @@
 #include <Arduino.h>
 #include <LiquidCrystal_I2C.h>
 
+#include <RefreshPolicy.hpp>
+
+#include "GlyphCache.hpp"
+
 /**
- * Struct CustomCharacters
+ * Struct LCDData
  *
- * it holds custom character that used on the display screen.
+ * Snapshot of everything the pages can show.
  */
-struct CustomCharacters {
-    const uint8_t sizes = 7;
-    const char char_bytes[7][8] = {
-       {0x01, 0x02, 0x1E, 0x02, 0x0E, 0x02, 0x06, 0x02},
-       {0x10, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08},
-       {0x02, 0x03, 0x07, 0x0F, 0x0F, 0x0F, 0x0F, 0x07},
-       {0x08, 0x18, 0x1C, 0x1E, 0x1E, 0x1E, 0x1E, 0x1C},
-       {0x04, 0x0A, 0x0A, 0x0A, 0x0E, 0x1F, 0x1F, 0x0E},    // temp
-       {0x07, 0x05, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00},    // deg
-       {0x00, 0x0C, 0x05, 0x17, 0x1C, 0x04, 0x06, 0x00},    // fan
-    };
-    const uint8_t char_pos[7][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}, {5, 0}, {11, 0}, {5, 1}};
+struct LCDData {
+    float temperature_c = 0.0F;
+    /** Temperature sensor is lost, `temperature_c` is stale and the fan runs on its safe duty */
+    bool is_fail_safe = false;
+    /** Fan speed indicator (0, 1, 2, 3) of the duty actually applied */
+    uint8_t fan_speed = 3;
+
+    int8_t desired_temp_c           = 0;
+    int8_t desired_temp_threshold_c = 0;
+
+    /** 100 == brightest, 0 == darkest */
+    uint8_t ldr_precentage = 0;
+    bool has_living_object = false;
+
+    bool is_wifi_connected  = false;
+    bool is_cloud_connected = false;
 };
 
 /**
@@ -31,31 +39,70 @@ struct CustomCharacters {
  *
  * Features:
  * 1. Toggle on and off
- * 2. Dynamic data (temperature and fan speed)
+ * 2. Dynamic data on rotating pages (home, setpoint, light, room, network, uptime)
+ * 3. Adaptive refresh, render on change and back off while idle
+ * 4. Backlight follows room presence and ambient light
+ *
+ * Pages are composed into a back buffer and only the cells that differ from
+ * the screen are sent, so a page transition never clears the display.
  */
 class LCDController {
- private:
-    /** Struct that holds our custom characters map */
-    CustomCharacters _custom_chars;
+ public:
+    static const uint8_t COLS = 16;
+    static const uint8_t ROWS = 2;
+
+    enum Page : uint8_t {
+        PAGE_HOME = 0,
+        PAGE_SETPOINT,
+        PAGE_LIGHT,
+        PAGE_ROOM,
+        PAGE_NETWORK,
+        PAGE_UPTIME,
+        PAGE_COUNT
+    };
 
+ private:
     LiquidCrystal_I2C _lcd;
+    GlyphCache _glyphs;
     bool _initialized;
 
-    /** Turn on/off the display screen */
+    /** Turn on/off the display screen (user preference) */
     bool _is_backlight_on;
+    /** Actual backlight state on the module */
+    bool _is_backlight_lit;
 
     /**
-     * LCD will update its screen periodically,
-     *  I'm using the power of timing with `millis()` tp handle it.
-     *
-     * Communication with i2c and updating the LCD oftenly is really expensive!
+     * Cells are either printable ASCII or `CELL_GLYPH | glyph`.
+     * `CELL_UNKNOWN` in the front buffer forces the cell to be rewritten.
      */
-    const unsigned long SCREEN_UPDATE_TIME = 5000UL;
-    unsigned long _latest_update;
+    static const uint8_t CELL_UNKNOWN = 0x00;
+    static const uint8_t CELL_GLYPH   = 0x80;
+    uint8_t _front[ROWS][COLS];
+    uint8_t _back[ROWS][COLS];
+
+    /** Where the LCD address counter points, `COLS` when unknown */
+    uint8_t _cursor_col;
+    uint8_t _cursor_row;
 
-    /** Some local cache */
-    int16_t _temperature_counter;
-    uint8_t _fan_speed_counter;
+    /** Cells sent per `update()`, a page transition is spread over a few calls */
+    const uint8_t FLUSH_BUDGET = 16;
+    bool _is_flushing;
+
+    /** Refresh, page and backlight timing */
+    RefreshPolicy _policy;
+    uint8_t _page;
+
+    /**
+     * Optional PWM pin that drives the backlight LED (jumper removed from the backpack).
+     * Without it the backpack can only switch the backlight, so dimming is skipped.
+     */
+    int8_t _backlight_pin;
+    /** Dimming steps, a new duty is only written when the step changes */
+    const uint8_t BACKLIGHT_LEVELS    = 8;
+    const uint16_t BACKLIGHT_MIN_DUTY = 128;
+    const uint16_t BACKLIGHT_MAX_DUTY = 1023;
+    uint8_t _ambient_precentage;
+    uint8_t _backlight_level;
 
  public:
     /**
@@ -69,19 +116,22 @@ class LCDController {
     /** Copy constructor is not allowed here */
     LCDController(const LCDController &) = delete;
 
-    /** Initiate the library */
-    void begin();
+    /**
+     * Initiate the library
+     *
+     * @param backlight_pin PWM pin wired to the backlight LED, -1 if the backpack drives it
+     */
+    void begin(int8_t backlight_pin = -1);
 
     /**
      * Update the screen with newest parameters.
      *
-     * The LCD will not immediately update and re-render the screen,
-     * though it will wait till it hit its timing.
+     * A value that changed beyond its display resolution is rendered on the next call
+     * past `RefreshPolicy::SCREEN_UPDATE_MIN_TIME`, otherwise the screen waits for its backed off timing.
      *
-     * @param temperature Temperature real-time sensor's value
-     * @param fan_speed Fan speed indicator (0, 1, 2, 3)
+     * @param data Latest sensors, actuators and connection states
      */
-    void update(float temperature, uint8_t fan_speed);
+    void update(const LCDData &data);
 
     /**
      * Check whether the LCD screen is turned on or off
@@ -98,10 +148,32 @@ class LCDController {
     void setBlacklightOn(bool on);
 
  private:
-    /** Re-render the fan's speed data */
-    void loadFanSpeed(uint8_t fan_speed);
-    /** Re-render the temperature sensor data */
-    void loadTemperature(float temperature);
+    /** Apply the lit state and ambient light to the backlight */
+    void applyBacklight(bool is_lit);
+
+    /** Render the current page into the back buffer */
+    void composePage(const LCDData &data);
+    /** Render the fan's speed data */
+    void composeFanSpeed(uint8_t col, uint8_t row, uint8_t fan_speed);
+    /** Render the temperature sensor data */
+    void composeTemperature(uint8_t col, uint8_t row, float temperature);
+
+    /** Back buffer helpers */
+    void putText(uint8_t col, uint8_t row, const char *text);
+    void putGlyph(uint8_t col, uint8_t row, uint8_t glyph);
+
+    /**
+     * Send the cells that differ between the back buffer and the screen
+     *
+     * @param budget Maximum cells to send
+     *
+     * @return bool True once the screen matches the back buffer
+     */
+    bool flush(uint8_t budget);
+    /** Bitmask of CGRAM slots used by the screen or the back buffer */
+    uint8_t usedSlots();
+    /** Send one cell, moving the cursor only when it is not already there */
+    void writeCell(uint8_t col, uint8_t row, uint8_t cell, uint8_t slot);
 };
 
 #endif // KF_LCDCONTROLLER_HPP
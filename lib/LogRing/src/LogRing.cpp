@@ -0,0 +1,94 @@
+#include "LogRing.hpp"
+
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+/** The writer runs from ISRs on the device, it has to stay in IRAM */
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+const uint8_t LogRing::FRAME_SYNC_0;
+const uint8_t LogRing::FRAME_SYNC_1;
+const uint32_t LogRing::HEADER_MAGIC;
+const uint8_t LogRing::RECORD_WORDS;
+
+LogRing::LogRing(volatile uint32_t *buffer, uint32_t words, Micros micros, Enter enter, Leave leave)
+    : _buffer(buffer)
+    , _mask(words - 1)
+    , _head(0)
+    , _tail(0)
+    , _dropped(0)
+    , _micros(micros)
+    , _enter(enter)
+    , _leave(leave) {
+    for (uint32_t i = 0; i < words; ++i) {
+        _buffer[i] = 0;
+    }
+}
+
+void IRAM_ATTR LogRing::push(uint32_t fmt, const uint32_t *args, uint8_t count) {
+    uint32_t words = RECORD_WORDS + count;
+
+    // single core without compare-and-swap, the critical section only covers the index bump
+    uint32_t state = _enter();
+    uint32_t head  = _head;
+    if (_mask + 1 - (head - _tail) < words) {
+        ++_dropped;
+        _leave(state);
+        return;
+    }
+    _head = head + words;
+    _leave(state);
+
+    _buffer[(head + 1) & _mask] = fmt;
+    _buffer[(head + 2) & _mask] = static_cast<uint32_t>(_micros());
+    for (uint8_t i = 0; i < count; ++i) {
+        _buffer[(head + RECORD_WORDS + i) & _mask] = args[i];
+    }
+
+    // publish, the buffer is volatile so this store stays last
+    _buffer[head & _mask] = HEADER_MAGIC | words << 8 | static_cast<uint32_t>(count) << 16;
+}
+
+uint8_t LogRing::peek() {
+    if (_tail == _head) {
+        return 0;
+    }
+
+    uint32_t header = _buffer[_tail & _mask];
+    if ((header & 0xFF) != HEADER_MAGIC) {
+        return 0;
+    }
+
+    return (header >> 8) & 0xFF;
+}
+
+size_t LogRing::pop(uint8_t *frame) {
+    uint8_t words = peek();
+    if (words == 0) {
+        return 0;
+    }
+
+    frame[0] = FRAME_SYNC_0;
+    frame[1] = FRAME_SYNC_1;
+
+    uint32_t tail = _tail;
+    for (uint8_t i = 0; i < words; ++i) {
+        uint32_t word = _buffer[(tail + i) & _mask];
+        memcpy(frame + 2 + i * 4, &word, sizeof(word));
+
+        // a stale word must never look like a published header
+        _buffer[(tail + i) & _mask] = 0;
+    }
+    _tail = tail + words;
+
+    return 2 + words * 4;
+}
+
+uint32_t LogRing::getDropped() {
+    return _dropped;
+}
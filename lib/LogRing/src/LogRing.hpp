@@ -0,0 +1,97 @@
+#ifndef KF_LOGRING_HPP
+#define KF_LOGRING_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Log Ring
+ *
+ * Record ring buffer of the Binary Logger, kept free of any hardware call so it runs on the host.
+ *
+ * Features:
+ * 1. Writers reserve their words inside a short critical section, then fill them outside of it
+ * 2. The header is published last, the drain stops at the first record that is not complete yet
+ * 3. A record that does not fit is dropped and counted, the writer never waits
+ * 4. Released words are cleared, a stale header never passes for a published one
+ *
+ * The clock and the critical section are injected, `micros` and an interrupt mask on the device.
+ * The hooks and the clock have to live in IRAM there, `push()` is called from ISRs.
+ *
+ * inside your loop()
+ *    while (ring.peek() > 0) {
+ *        send(frame, ring.pop(frame))
+ *    }
+ *
+ * Record (little endian words):
+ *    header (0xB1 | words << 8 | args << 16), format address, micros(), args...
+ * Frame:
+ *    0xA5 0x5A record
+ */
+class LogRing {
+ public:
+    /** Microseconds since boot */
+    typedef unsigned long (*Micros)();
+    /** Exclude nested writers, returns the state `Leave` restores */
+    typedef uint32_t (*Enter)();
+    typedef void (*Leave)(uint32_t state);
+
+    static const uint8_t FRAME_SYNC_0  = 0xA5;
+    static const uint8_t FRAME_SYNC_1  = 0x5A;
+    static const uint32_t HEADER_MAGIC = 0xB1;
+    static const uint8_t RECORD_WORDS  = 3;
+
+ private:
+    /**
+     * Writers reserve [_head, _head + words) and publish the header last,
+     * a zero header tells the drain that the record is not complete yet.
+     */
+    volatile uint32_t *_buffer;
+    uint32_t _mask;
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+    volatile uint32_t _dropped;
+
+    Micros _micros;
+    Enter _enter;
+    Leave _leave;
+
+ public:
+    /**
+     * @param buffer Storage of the records, it is cleared here
+     * @param words Size of the storage in 4 bytes words, must be a power of two
+     * @param micros Timestamp of the records
+     * @param enter Start of the critical section around a reservation
+     * @param leave End of the critical section around a reservation
+     */
+    LogRing(volatile uint32_t *buffer, uint32_t words, Micros micros, Enter enter, Leave leave);
+
+    /** Copy constructor is not allowed here */
+    LogRing(const LogRing &) = delete;
+
+    /**
+     * Reserve, fill and publish a record, callable from an ISR
+     *
+     * @param fmt Format string address
+     * @param args Raw 32 bits arguments
+     * @param count Number of arguments
+     */
+    void push(uint32_t fmt, const uint32_t *args, uint8_t count);
+
+    /** Words of the next complete record, 0 when there is none */
+    uint8_t peek();
+
+    /**
+     * Move the next record into a frame and release its words
+     *
+     * @param frame Room for 2 bytes and the words given by `peek()`
+     *
+     * @return size_t Size of the frame, 0 when there is no complete record
+     */
+    size_t pop(uint8_t *frame);
+
+    /** Records lost because the buffer was full */
+    uint32_t getDropped();
+};
+
+#endif    // KF_LOGRING_HPP
@@ -0,0 +1,131 @@
+#include "PowerManager.hpp"
+
+#include <ESP8266WiFi.h>
+
+PowerManager::PowerManager()
+    : _initialized(false)
+    , _mode(MODE_ACTIVE)
+    , _idle_mode(MODE_MODEM_SLEEP)
+    , _window(millis, delay, digitalRead)
+    , _latest_mark(0) {
+    memset(&_record, 0, sizeof(_record));
+}
+
+void PowerManager::begin(Mode idle_mode, int8_t wake_pin) {
+    if (_initialized) {
+        return;
+    }
+
+    _idle_mode = idle_mode == MODE_ACTIVE ? MODE_MODEM_SLEEP : idle_mode;
+    _window.begin(wake_pin);
+
+    ESP.rtcUserMemoryRead(POWER_RTC_OFFSET, reinterpret_cast<uint32_t *>(&_record), sizeof(_record));
+    if (_record.magic != RECORD_MAGIC) {
+        memset(&_record, 0, sizeof(_record));
+        _record.magic = RECORD_MAGIC;
+    }
+
+    setMode(MODE_ACTIVE);
+    _latest_mark = millis();
+
+    _initialized = true;
+}
+
+void PowerManager::handle(bool is_idle, unsigned long next_task_ms) {
+    if (!_initialized) {
+        return;
+    }
+
+    account(false);
+
+    if (!is_idle || next_task_ms == 0) {
+        if (!is_idle) {
+            setMode(MODE_ACTIVE);
+        }
+        store();
+        return;
+    }
+
+    setMode(_idle_mode);
+
+    // `delay()` hands the CPU to the SDK, which lets the radio (and CPU in light sleep) rest
+    if (_window.sleep(next_task_ms)) {
+        ++_record.pin_wakes;
+    } else {
+        ++_record.timer_wakes;
+    }
+
+    account(true);
+    store();
+}
+
+PowerManager::Mode PowerManager::getMode() {
+    return _mode;
+}
+
+float PowerManager::getDutyCycle() {
+    uint32_t total = _record.active_ms + _record.idle_ms;
+    if (total == 0) {
+        return 1.0F;
+    }
+
+    return static_cast<float>(_record.active_ms) / total;
+}
+
+float PowerManager::getAverageCurrent() {
+    float duty       = getDutyCycle();
+    float idle_ma    = _idle_mode == MODE_LIGHT_SLEEP ? CURRENT_LIGHT_SLEEP_MA : CURRENT_MODEM_SLEEP_MA;
+    float average_ma = duty * CURRENT_ACTIVE_MA + (1.0F - duty) * idle_ma;
+
+    return average_ma;
+}
+
+unsigned long PowerManager::getLastWakeLatency() {
+    return _window.getLastWakeLatency();
+}
+
+const PowerManager::Record &PowerManager::getRecord() {
+    return _record;
+}
+
+void PowerManager::setMode(Mode mode) {
+    if (mode == _mode && _initialized) {
+        return;
+    }
+    _mode = mode;
+
+    switch (mode) {
+        case MODE_LIGHT_SLEEP:
+            WiFi.setSleepMode(WIFI_LIGHT_SLEEP, LISTEN_INTERVAL);
+            break;
+        case MODE_MODEM_SLEEP:
+            WiFi.setSleepMode(WIFI_MODEM_SLEEP);
+            break;
+        case MODE_ACTIVE:
+        default:
+            WiFi.setSleepMode(WIFI_NONE_SLEEP);
+            break;
+    }
+}
+
+void PowerManager::account(bool is_idle) {
+    unsigned long current_millis = millis();
+    uint32_t elapsed             = current_millis - _latest_mark;
+    _latest_mark                 = current_millis;
+
+    if (is_idle) {
+        _record.idle_ms += elapsed;
+    } else {
+        _record.active_ms += elapsed;
+    }
+
+    // halve both before they overflow, the ratio is all that matters
+    if (_record.active_ms > 0x80000000UL || _record.idle_ms > 0x80000000UL) {
+        _record.active_ms /= 2;
+        _record.idle_ms /= 2;
+    }
+}
+
+void PowerManager::store() {
+    ESP.rtcUserMemoryWrite(POWER_RTC_OFFSET, reinterpret_cast<uint32_t *>(&_record), sizeof(_record));
+}
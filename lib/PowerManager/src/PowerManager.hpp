@@ -0,0 +1,113 @@
+#ifndef KF_POWERMANAGER_HPP
+#define KF_POWERMANAGER_HPP
+
+#include <Arduino.h>
+#include <SleepWindow.hpp>
+
+/** First RTC user memory block used by the power record, the supervisor owns blocks 0-15 */
+#ifndef POWER_RTC_OFFSET
+#define POWER_RTC_OFFSET 16
+#endif
+
+/**
+ * Power Manager
+ *
+ * Let the radio sleep between scheduled tasks while the room is idle.
+ *
+ * Features:
+ * 1. Modem sleep or automatic light sleep while idle, no sleep while active
+ * 2. Sleeps are bounded by the next scheduled task, so no sensor sample is missed
+ * 3. Early wake up on an edge of the wake pin (PIR)
+ * 4. Duty cycle and average current estimates, kept in RTC memory across resets
+ *
+ * inside your loop()
+ *    power_manager.handle(is_idle, ms_until_next_task)
+ */
+class PowerManager {
+ public:
+    enum Mode : uint8_t {
+        MODE_ACTIVE = 0,
+        /** Radio sleeps between beacons, CPU keeps running */
+        MODE_MODEM_SLEEP,
+        /** Radio and CPU sleep inside `delay()`, the connection is kept */
+        MODE_LIGHT_SLEEP
+    };
+
+    /**
+     * Rough supply current of a NodeMCU in each mode (mA), used for the estimates.
+     */
+    static const uint8_t CURRENT_ACTIVE_MA      = 80;
+    static const uint8_t CURRENT_MODEM_SLEEP_MA = 15;
+    static const uint8_t CURRENT_LIGHT_SLEEP_MA = 3;
+
+    /** Survives any reset but a power loss */
+    struct Record {
+        uint32_t magic;
+        uint32_t active_ms;
+        uint32_t idle_ms;
+        uint32_t pin_wakes;
+        uint32_t timer_wakes;
+    };
+
+ private:
+    static const uint32_t RECORD_MAGIC = 0x4B46504DUL;
+
+    bool _initialized;
+    Mode _mode;
+    Mode _idle_mode;
+
+    /** Sleep bounded by the next task and the wake pin */
+    SleepWindow _window;
+    /** Beacons skipped by the radio in light sleep (DTIM multiplier) */
+    const uint8_t LISTEN_INTERVAL = 3;
+
+    Record _record;
+    unsigned long _latest_mark;
+
+ public:
+    PowerManager();
+
+    /** Copy constructor is not allowed here */
+    PowerManager(const PowerManager &) = delete;
+
+    /**
+     * Load the statistics from RTC memory
+     *
+     * @param idle_mode `MODE_MODEM_SLEEP` or `MODE_LIGHT_SLEEP`
+     * @param wake_pin Pin that ends a sleep on any edge, -1 for timer only
+     */
+    void begin(Mode idle_mode, int8_t wake_pin = -1);
+
+    /**
+     * Call it at the end of every loop.
+     *
+     * When idle, it sleeps until the next task is due (at most `SleepWindow::MAX_SLEEP_TIME`)
+     * or the wake pin changes. Otherwise it makes sure the radio stays awake.
+     *
+     * @param is_idle True when nothing needs the device to be responsive
+     * @param next_task_ms Time until the next scheduled task
+     */
+    void handle(bool is_idle, unsigned long next_task_ms);
+
+    Mode getMode();
+
+    /** Share of time spent active, 0.0 - 1.0 */
+    float getDutyCycle();
+
+    /** Estimated average supply current in mA */
+    float getAverageCurrent();
+
+    /** Upper bound of the time between the latest wake pin edge and the end of its sleep, in ms */
+    unsigned long getLastWakeLatency();
+
+    /** Statistics since the last power loss */
+    const Record &getRecord();
+
+ private:
+    void setMode(Mode mode);
+    /** Add the time since the latest mark to the active or idle counter */
+    void account(bool is_idle);
+    void store();
+};
+
+#endif    // KF_POWERMANAGER_HPP
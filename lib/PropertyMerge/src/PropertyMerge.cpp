@@ -0,0 +1,40 @@
+#include "PropertyMerge.hpp"
+
+const uint8_t PropertyMerge::MAX_FIELDS;
+
+uint8_t PropertyMerge::merge(MergeField *fields, uint8_t count, bool is_newer) {
+    // sections edited by the cloud, decided before the loop below moves any base
+    bool is_edited[MAX_FIELDS] = {false};
+    count                      = count < MAX_FIELDS ? count : MAX_FIELDS;
+
+    for (uint8_t i = 0; i < count; ++i) {
+        if (fields[i].cloud != fields[i].base && fields[i].section < MAX_FIELDS) {
+            is_edited[fields[i].section] = true;
+        }
+    }
+
+    uint8_t result = RESULT_NONE;
+
+    for (uint8_t i = 0; i < count; ++i) {
+        MergeField &field = fields[i];
+
+        // another writer bumped the version, the sections it edited are taken as a whole.
+        // Dashboard edits keep the version, they are caught field by field.
+        bool is_section_edited = is_newer && field.section < MAX_FIELDS && is_edited[field.section];
+
+        if (field.cloud != field.base || is_section_edited) {
+            if (field.value != field.cloud) {
+                field.value = field.cloud;
+                result |= RESULT_APPLIED;
+            }
+        }
+
+        field.base = field.value;
+
+        if (field.value != field.cloud) {
+            result |= RESULT_DIRTY;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef KF_PROPERTYMERGE_HPP
+#define KF_PROPERTYMERGE_HPP
+
+#include <stdint.h>
+
+/**
+ * Struct MergeField
+ *
+ * One bound field as seen by a merge.
+ */
+struct MergeField {
+    /** Index of the first field of the same section, fields of a section share it */
+    uint8_t section;
+    /** Value the cloud held at the latest fetch or write */
+    int16_t base;
+    /** Local value, it holds the merged value after `merge()` */
+    int16_t value;
+    /** Value the cloud holds now */
+    int16_t cloud;
+};
+
+/**
+ * Property Merge
+ *
+ * Merge rule of the Property Sync, kept free of any cloud call so it runs on the host.
+ *
+ * Features:
+ * 1. A field the cloud changed since the latest sync takes the cloud value
+ * 2. When another writer bumped the version, every section it edited is taken as a whole
+ * 3. Edited sections are found from the bases before any of them is moved, the field
+ *    order does not matter
+ *
+ * inside your flush()
+ *    uint8_t result = PropertyMerge::merge(fields, count, cloud_version > version);
+ *    if (result & PropertyMerge::RESULT_DIRTY) {
+ *        write(fields)
+ *    }
+ */
+class PropertyMerge {
+ public:
+    static const uint8_t MAX_FIELDS = 16;
+
+    /** Outcome of a merge, bit flags */
+    enum Result : uint8_t {
+        RESULT_NONE = 0,
+        /** A cloud value replaced a local one */
+        RESULT_APPLIED = 1,
+        /** A merged value differs from the cloud, it has to be written */
+        RESULT_DIRTY = 2
+    };
+
+    /**
+     * Merge local values with the cloud, every base moves to the merged value
+     *
+     * @param fields Bound fields, at most `MAX_FIELDS`
+     * @param count Number of fields
+     * @param is_newer True when the cloud version is newer than the one of the bases
+     *
+     * @return uint8_t `Result` flags
+     */
+    static uint8_t merge(MergeField *fields, uint8_t count, bool is_newer);
+};
+
+#endif    // KF_PROPERTYMERGE_HPP
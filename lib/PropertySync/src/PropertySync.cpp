@@ -0,0 +1,283 @@
+#include "PropertySync.hpp"
+
+PropertySync::PropertySync(ThingerClient &thing, const char *property)
+    : _thing(thing)
+    , _property(property)
+    , _count(0)
+    , _version(0)
+    , _latest_change(0)
+    , _is_dirty(false)
+    , _on_apply(nullptr)
+    , _section(nullptr)
+    , _on_section(nullptr) {
+}
+
+bool PropertySync::bind(const char *section, const char *key, bool *value) {
+    return bindField(section, key, FIELD_BOOL, value);
+}
+
+bool PropertySync::bind(const char *section, const char *key, int8_t *value) {
+    return bindField(section, key, FIELD_INT8, value);
+}
+
+bool PropertySync::bind(const char *section, const char *key, uint8_t *value) {
+    return bindField(section, key, FIELD_UINT8, value);
+}
+
+void PropertySync::onApply(void (*callback)()) {
+    _on_apply = callback;
+}
+
+void PropertySync::onSection(const char *section, void (*callback)(pson &section)) {
+    _section    = section;
+    _on_section = callback;
+}
+
+bool PropertySync::fetch() {
+    pson data;
+    if (!_thing.get_property(_property, data)) {
+        return false;
+    }
+
+    _version = (uint32_t) data["version"];
+
+    // deployments from before the single property keep one property per section,
+    // a migrated section is written to the single property so it is read only once
+    bool is_missing = false;
+
+    for (uint8_t i = 0; i < _count; ++i) {
+        if (_fields[i].section_index == i && !data[_fields[i].section].is_object()) {
+            is_missing |= migrateSection(data, _fields[i].section);
+        }
+    }
+
+    if (_on_section != nullptr && !data[_section].is_object()) {
+        is_missing |= migrateSection(data, _section);
+    }
+
+    // a field found nowhere would read as 0, keep the local value and let the cloud learn it
+
+    for (uint8_t i = 0; i < _count; ++i) {
+        Field &field = _fields[i];
+
+        if (hasCloud(data, field)) {
+            writeLocal(field, readCloud(data, field));
+        } else {
+            is_missing = true;
+        }
+
+        field.base   = readLocal(field);
+        field.shadow = field.base;
+    }
+    _is_dirty = false;
+
+    if (_on_apply != nullptr) {
+        _on_apply();
+    }
+
+    if (_on_section != nullptr && data[_section].is_object()) {
+        _on_section(data[_section]);
+    }
+
+    if (is_missing || !data["version"].is_number()) {
+        for (uint8_t i = 0; i < _count; ++i) {
+            writeCloud(data, _fields[i], _fields[i].base);
+        }
+
+        data["version"] = _version + 1;
+        if (_thing.set_property(_property, data)) {
+            ++_version;
+        }
+    }
+
+    return true;
+}
+
+void PropertySync::handle() {
+    unsigned long current_millis = millis();
+    bool is_dirty                = false;
+
+    // a cheap scan, no call site has to flag its changes
+    for (uint8_t i = 0; i < _count; ++i) {
+        Field &field  = _fields[i];
+        int16_t value = readLocal(field);
+
+        if (value != field.shadow) {
+            field.shadow   = value;
+            _latest_change = current_millis;
+        }
+
+        // a field that went back to its base value is clean again
+        if (value != field.base) {
+            is_dirty = true;
+        }
+    }
+    _is_dirty = is_dirty;
+
+    if (!_is_dirty || current_millis - _latest_change < DEBOUNCE_TIME) {
+        return;
+    }
+
+    if (!flush()) {
+        // offline or rejected, try again after another debounce period
+        _latest_change = current_millis;
+    }
+}
+
+bool PropertySync::flush() {
+    pson data;
+    if (!_thing.get_property(_property, data)) {
+        return false;
+    }
+
+    uint32_t cloud_version = (uint32_t) data["version"];
+    MergeField merged[MAX_FIELDS];
+
+    for (uint8_t i = 0; i < _count; ++i) {
+        merged[i].section = _fields[i].section_index;
+        merged[i].base    = _fields[i].base;
+        merged[i].value   = readLocal(_fields[i]);
+        merged[i].cloud   = readCloud(data, _fields[i]);
+    }
+
+    uint8_t result  = PropertyMerge::merge(merged, _count, cloud_version > _version);
+    bool is_applied = result & PropertyMerge::RESULT_APPLIED;
+    bool is_dirty   = result & PropertyMerge::RESULT_DIRTY;
+
+    for (uint8_t i = 0; i < _count; ++i) {
+        Field &field = _fields[i];
+
+        if (merged[i].value != readLocal(field)) {
+            writeLocal(field, merged[i].value);
+            field.shadow = merged[i].value;
+        }
+
+        writeCloud(data, field, merged[i].value);
+        field.base = merged[i].base;
+    }
+
+    if (is_applied && _on_apply != nullptr) {
+        _on_apply();
+    }
+
+    // every local change gave way to the cloud, nothing left to write
+    if (!is_dirty) {
+        _version  = cloud_version;
+        _is_dirty = false;
+        return true;
+    }
+
+    uint32_t version = max(cloud_version, _version) + 1;
+    data["version"]  = version;
+
+    if (!_thing.set_property(_property, data)) {
+        // the cloud still holds its own values, keep ours dirty against them
+        for (uint8_t i = 0; i < _count; ++i) {
+            _fields[i].base = merged[i].cloud;
+        }
+        return false;
+    }
+
+    _version  = version;
+    _is_dirty = false;
+
+    return true;
+}
+
+bool PropertySync::isDirty() {
+    return _is_dirty;
+}
+
+uint32_t PropertySync::getVersion() {
+    return _version;
+}
+
+bool PropertySync::bindField(const char *section, const char *key, FieldType type, void *value) {
+    if (_count >= MAX_FIELDS) {
+        return false;
+    }
+
+    Field &field        = _fields[_count];
+    field.section       = section;
+    field.section_index = findSection(section);
+    field.key           = key;
+    field.type          = type;
+    field.value         = value;
+    field.base          = readLocal(field);
+    field.shadow        = field.base;
+    ++_count;
+
+    return true;
+}
+
+int16_t PropertySync::readLocal(const Field &field) {
+    switch (field.type) {
+        case FIELD_BOOL:
+            return *static_cast<bool *>(field.value);
+        case FIELD_INT8:
+            return *static_cast<int8_t *>(field.value);
+        case FIELD_UINT8:
+        default:
+            return *static_cast<uint8_t *>(field.value);
+    }
+}
+
+void PropertySync::writeLocal(Field &field, int16_t value) {
+    switch (field.type) {
+        case FIELD_BOOL:
+            *static_cast<bool *>(field.value) = value != 0;
+            break;
+        case FIELD_INT8:
+            *static_cast<int8_t *>(field.value) = static_cast<int8_t>(value);
+            break;
+        case FIELD_UINT8:
+        default:
+            *static_cast<uint8_t *>(field.value) = static_cast<uint8_t>(value);
+            break;
+    }
+}
+
+bool PropertySync::hasCloud(pson &data, const Field &field) {
+    pson &section = data[field.section];
+
+    return section.is_object() && !section[field.key].is_empty();
+}
+
+int16_t PropertySync::readCloud(pson &data, const Field &field) {
+    return readValue(data[field.section][field.key], field.type);
+}
+
+int16_t PropertySync::readValue(pson &value, FieldType type) {
+    switch (type) {
+        case FIELD_BOOL:
+            return (bool) value;
+        case FIELD_INT8:
+            return (int8_t) value;
+        case FIELD_UINT8:
+        default:
+            return (uint8_t) value;
+    }
+}
+
+void PropertySync::writeCloud(pson &data, const Field &field, int16_t value) {
+    if (field.type == FIELD_BOOL) {
+        data[field.section][field.key] = value != 0;
+    } else {
+        data[field.section][field.key] = value;
+    }
+}
+
+uint8_t PropertySync::findSection(const char *section) {
+    for (uint8_t i = 0; i < _count; ++i) {
+        if (strcmp(_fields[i].section, section) == 0) {
+            return i;
+        }
+    }
+
+    return _count;
+}
+
+bool PropertySync::migrateSection(pson &data, const char *section) {
+    // the legacy property holds the section content itself
+    return _thing.get_property(section, data[section]) && data[section].is_object();
+}
@@ -0,0 +1,148 @@
+#ifndef KF_PROPERTYSYNC_HPP
+#define KF_PROPERTYSYNC_HPP
+
+#include <Arduino.h>
+#include <PropertyMerge.hpp>
+#include <ThingerClient.h>
+
+/**
+ * Property Sync
+ *
+ * Keep local state and a single Thinger property in sync.
+ *
+ * Features:
+ * 1. Every section (e.g. `fan_state`, `lcd_state`) lives in one property, fetched in one round trip.
+ *    A section that is not made of bound fields (e.g. `schedule`) is handed to a callback from the same read
+ * 2. Bound fields are watched, local changes are tracked as dirty without touching the call sites
+ * 3. Dirty fields are coalesced into one debounced `set_property` write
+ * 4. Newer cloud edits are never overwritten: every write bumps `version`, a section edited
+ *    by a newer version wins as a whole over the local changes, and per field base values
+ *    catch dashboard edits that keep the version
+ * 5. A section missing from the property is read once from its legacy property (named after
+ *    the section), a field found nowhere keeps its local value and is written to the cloud
+ *
+ * Property layout:
+ *    { "version": 12, "fan_state": { ... }, "lcd_state": { ... }, "schedule": { ... } }
+ */
+class PropertySync {
+ public:
+    static const uint8_t MAX_FIELDS = PropertyMerge::MAX_FIELDS;
+
+    enum FieldType : uint8_t {
+        FIELD_BOOL = 0,
+        FIELD_INT8,
+        FIELD_UINT8
+    };
+
+ private:
+    struct Field {
+        const char *section;
+        /** Index of the first field bound to the same section */
+        uint8_t section_index;
+        const char *key;
+        FieldType type;
+        void *value;
+        /** Value the cloud held at the latest fetch or write */
+        int16_t base;
+        /** Value seen by the latest `handle()` */
+        int16_t shadow;
+    };
+
+    ThingerClient &_thing;
+    const char *_property;
+
+    Field _fields[MAX_FIELDS];
+    uint8_t _count;
+
+    /** Cloud version the base values belong to */
+    uint32_t _version;
+
+    /** Write once the fields stopped changing for this long */
+    const unsigned long DEBOUNCE_TIME = 2000UL;
+    unsigned long _latest_change;
+    bool _is_dirty;
+
+    /** Called after cloud values were applied to the bound fields */
+    void (*_on_apply)();
+
+    /** Section read as a whole by `_on_section` at every fetch */
+    const char *_section;
+    void (*_on_section)(pson &section);
+
+ public:
+    /**
+     * @param thing Connected Thinger client
+     * @param property Property identifier that holds every section
+     */
+    PropertySync(ThingerClient &thing, const char *property);
+
+    /** Copy constructor is not allowed here */
+    PropertySync(const PropertySync &) = delete;
+
+    /**
+     * Bind a local variable to `property[section][key]`
+     *
+     * @return bool False when there is no room left
+     */
+    bool bind(const char *section, const char *key, bool *value);
+    bool bind(const char *section, const char *key, int8_t *value);
+    bool bind(const char *section, const char *key, uint8_t *value);
+
+    /** Set the callback that pushes applied values into the controllers */
+    void onApply(void (*callback)());
+
+    /**
+     * Hand a section that is not made of bound fields to a callback at every fetch.
+     * The callback is skipped while the section is found nowhere.
+     *
+     * @param section Section identifier, also the name of its legacy property
+     * @param callback Reads the section content
+     */
+    void onSection(const char *section, void (*callback)(pson &section));
+
+    /**
+     * Read the property and apply every field found in the cloud, the cloud wins.
+     *
+     * @return bool False when the property could not be read
+     */
+    bool fetch();
+
+    /**
+     * Call it inside loop(). It tracks local changes and writes them back
+     * once they settled for `DEBOUNCE_TIME`.
+     */
+    void handle();
+
+    /**
+     * Merge local changes with the cloud and write them now
+     *
+     * @return bool False when the property could not be read or written
+     */
+    bool flush();
+
+    /** Check whether local changes wait to be written */
+    bool isDirty();
+
+    uint32_t getVersion();
+
+ private:
+    bool bindField(const char *section, const char *key, FieldType type, void *value);
+
+    int16_t readLocal(const Field &field);
+    void writeLocal(Field &field, int16_t value);
+    bool hasCloud(pson &data, const Field &field);
+    int16_t readCloud(pson &data, const Field &field);
+    int16_t readValue(pson &value, FieldType type);
+    void writeCloud(pson &data, const Field &field, int16_t value);
+
+    /** Index of the first field bound to a section, `_count` when there is none yet */
+    uint8_t findSection(const char *section);
+    /**
+     * Read a section from its legacy property
+     *
+     * @return bool True when the legacy property exists
+     */
+    bool migrateSection(pson &data, const char *section);
+};
+
+#endif    // KF_PROPERTYSYNC_HPP
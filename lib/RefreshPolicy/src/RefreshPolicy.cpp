@@ -0,0 +1,125 @@
+#include "RefreshPolicy.hpp"
+
+const unsigned long RefreshPolicy::SCREEN_UPDATE_MIN_TIME;
+const unsigned long RefreshPolicy::SCREEN_REPAINT_TIME;
+const unsigned long RefreshPolicy::SCREEN_UPDATE_MAX_TIME;
+const unsigned long RefreshPolicy::PAGE_DWELL_TIME;
+const unsigned long RefreshPolicy::PRESENCE_TIMEOUT;
+constexpr float RefreshPolicy::TEMPERATURE_HYSTERESIS_C;
+
+RefreshPolicy::RefreshPolicy(Clock clock)
+    : _clock(clock)
+    , _update_interval(SCREEN_REPAINT_TIME)
+    , _latest_update(0)
+    , _latest_change(0)
+    , _is_page_changed(true)
+    , _page_since(0)
+    , _latest_presence(0)
+    , _occupied_since(0)
+    , _uptime_s(0)
+    , _uptime_ts(0)
+    , _temperature_counter(0) {
+}
+
+void RefreshPolicy::begin() {
+    unsigned long current_millis = now();
+
+    _update_interval = SCREEN_REPAINT_TIME;
+    _latest_update   = current_millis;
+    _latest_change   = current_millis;
+    _is_page_changed = true;
+    _page_since      = current_millis;
+    _latest_presence = current_millis;
+    _occupied_since  = current_millis;
+    _uptime_s        = 0;
+    _uptime_ts       = current_millis;
+}
+
+unsigned long RefreshPolicy::now() {
+    return _clock();
+}
+
+bool RefreshPolicy::updatePresence(bool is_backlight_on, bool has_living_object) {
+    if (has_living_object) {
+        if (!isOccupied()) {
+            _occupied_since = now();
+        }
+        _latest_presence = now();
+    }
+
+    return is_backlight_on && isOccupied();
+}
+
+bool RefreshPolicy::isOccupied() {
+    return now() - _latest_presence < PRESENCE_TIMEOUT;
+}
+
+unsigned long RefreshPolicy::getOccupiedTime() {
+    return now() - _occupied_since;
+}
+
+bool RefreshPolicy::isPageDue() {
+    unsigned long current_millis = now();
+
+    if (current_millis - _page_since < PAGE_DWELL_TIME) {
+        return false;
+    }
+
+    _page_since      = current_millis;
+    _is_page_changed = true;
+    return true;
+}
+
+bool RefreshPolicy::isComposeDue() {
+    unsigned long current_millis = now();
+
+    if (!_is_page_changed && current_millis - _latest_update < SCREEN_UPDATE_MIN_TIME) {
+        return false;
+    }
+
+    _latest_update   = current_millis;
+    _is_page_changed = false;
+    return true;
+}
+
+RefreshPolicy::Action RefreshPolicy::commit(bool is_changed) {
+    unsigned long current_millis = now();
+
+    if (is_changed) {
+        _latest_change   = current_millis;
+        _update_interval = SCREEN_REPAINT_TIME;
+        return ACTION_RENDER;
+    }
+
+    if (current_millis - _latest_change < _update_interval) {
+        return ACTION_NONE;
+    }
+
+    _latest_change   = current_millis;
+    _update_interval = _update_interval * 2 < SCREEN_UPDATE_MAX_TIME ? _update_interval * 2 : SCREEN_UPDATE_MAX_TIME;
+    return ACTION_REPAINT;
+}
+
+unsigned long RefreshPolicy::getUpdateInterval() {
+    return _update_interval;
+}
+
+int16_t RefreshPolicy::displayTemperature(float temperature) {
+    // displayed value is the truncated degree, leave it only past the hysteresis band
+    float lower = _temperature_counter - TEMPERATURE_HYSTERESIS_C;
+    float upper = _temperature_counter + 1 + TEMPERATURE_HYSTERESIS_C;
+
+    if (temperature < lower || temperature >= upper) {
+        _temperature_counter = static_cast<int16_t>(temperature);
+    }
+
+    return _temperature_counter;
+}
+
+unsigned long RefreshPolicy::getUptime() {
+    unsigned long seconds = (now() - _uptime_ts) / 1000UL;
+    _uptime_s += seconds;
+    _uptime_ts += seconds * 1000UL;
+
+    return _uptime_s;
+}
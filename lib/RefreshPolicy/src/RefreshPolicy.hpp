@@ -0,0 +1,138 @@
+#ifndef KF_REFRESHPOLICY_HPP
+#define KF_REFRESHPOLICY_HPP
+
+#include <stdint.h>
+
+/**
+ * Refresh Policy
+ *
+ * Timing decisions of the LCD, kept free of any hardware call so it runs on the host.
+ *
+ * Features:
+ * 1. Render on change, never faster than `SCREEN_UPDATE_MIN_TIME`
+ * 2. Healing repaint while idle, backed off up to `SCREEN_UPDATE_MAX_TIME`
+ * 3. Backlight off once nobody has been seen for `PRESENCE_TIMEOUT`
+ * 4. Page rotation, temperature hysteresis and an uptime that survives `millis()` wraparound
+ *
+ * Every elapsed time is an unsigned subtraction against the injected clock.
+ *
+ * inside your update()
+ *    if (policy.isComposeDue()) {
+ *        compose()
+ *        if (policy.commit(is_changed) != RefreshPolicy::ACTION_NONE) flush()
+ *    }
+ */
+class RefreshPolicy {
+ public:
+    /** Milliseconds since boot, `millis` on the device */
+    typedef unsigned long (*Clock)();
+
+    enum Action : uint8_t {
+        ACTION_NONE = 0,
+        /** Send the cells that changed */
+        ACTION_RENDER,
+        /** Rewrite every cell in case the screen got corrupted */
+        ACTION_REPAINT
+    };
+
+    /**
+     * LCD renders as soon as a displayed value changes, but never faster than
+     * `SCREEN_UPDATE_MIN_TIME`. While nothing changes, the whole screen is repainted
+     * after `SCREEN_REPAINT_TIME`, then with a doubling interval up to
+     * `SCREEN_UPDATE_MAX_TIME` to heal any i2c glitch.
+     *
+     * Communication with i2c and updating the LCD oftenly is really expensive!
+     */
+    static const unsigned long SCREEN_UPDATE_MIN_TIME = 500UL;
+    static const unsigned long SCREEN_REPAINT_TIME    = 4000UL;
+    static const unsigned long SCREEN_UPDATE_MAX_TIME = 64000UL;
+
+    /** Each page stays on the screen for this long */
+    static const unsigned long PAGE_DWELL_TIME = 5000UL;
+
+    /** Backlight goes off once nobody has been seen for this long */
+    static const unsigned long PRESENCE_TIMEOUT = 60000UL;
+
+    /** Temperature must leave the displayed degree by this much to be re-rendered */
+    static constexpr float TEMPERATURE_HYSTERESIS_C = 0.2F;
+
+ private:
+    Clock _clock;
+
+    unsigned long _update_interval;
+    unsigned long _latest_update;
+    unsigned long _latest_change;
+    bool _is_page_changed;
+    unsigned long _page_since;
+
+    unsigned long _latest_presence;
+    unsigned long _occupied_since;
+
+    /** Uptime survives `millis()` wraparound */
+    unsigned long _uptime_s;
+    unsigned long _uptime_ts;
+
+    /** Displayed degree */
+    int16_t _temperature_counter;
+
+ public:
+    /**
+     * @param clock Source of the elapsed milliseconds
+     */
+    explicit RefreshPolicy(Clock clock);
+
+    /** Start every timing from now, the room counts as occupied */
+    void begin();
+
+    /** Current time of the injected clock */
+    unsigned long now();
+
+    /**
+     * Feed the latest presence sample
+     *
+     * @param is_backlight_on User preference
+     * @param has_living_object PIR state
+     *
+     * @return bool True when the backlight should be lit
+     */
+    bool updatePresence(bool is_backlight_on, bool has_living_object);
+
+    /** Check whether anybody has been seen within `PRESENCE_TIMEOUT` */
+    bool isOccupied();
+
+    /** Milliseconds since the room became occupied after being empty */
+    unsigned long getOccupiedTime();
+
+    /**
+     * Check whether the current page stayed for `PAGE_DWELL_TIME`,
+     * it restarts the dwell time and forces the next compose.
+     */
+    bool isPageDue();
+
+    /** Check whether a new frame may be composed */
+    bool isComposeDue();
+
+    /**
+     * Decide what to do with the composed frame
+     *
+     * @param is_changed True when the frame differs from the screen
+     *
+     * @return Action
+     */
+    Action commit(bool is_changed);
+
+    /** Interval of the next healing repaint */
+    unsigned long getUpdateInterval();
+
+    /**
+     * Degree to display, it only follows the temperature past the hysteresis band
+     *
+     * @param temperature Latest reading in celcius
+     */
+    int16_t displayTemperature(float temperature);
+
+    /** Seconds since `begin()` */
+    unsigned long getUptime();
+};
+
+#endif    // KF_REFRESHPOLICY_HPP
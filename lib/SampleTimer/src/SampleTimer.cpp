@@ -0,0 +1,39 @@
+#include "SampleTimer.hpp"
+
+SampleTimer::SampleTimer(Clock clock, unsigned long sample_interval, unsigned long conversion_time)
+    : _clock(clock)
+    , _sample_interval(sample_interval)
+    , _conversion_time(conversion_time)
+    , _request_ts(0)
+    , _is_converting(false) {
+}
+
+void SampleTimer::setConversionTime(unsigned long conversion_time) {
+    _conversion_time = conversion_time;
+}
+
+SampleTimer::Action SampleTimer::poll() {
+    if (next() > 0) {
+        return ACTION_NONE;
+    }
+
+    if (_is_converting) {
+        _is_converting = false;
+        return ACTION_READ;
+    }
+
+    _request_ts    = _clock();
+    _is_converting = true;
+    return ACTION_REQUEST;
+}
+
+unsigned long SampleTimer::next() {
+    unsigned long wait    = _is_converting ? _conversion_time : _sample_interval;
+    unsigned long elapsed = _clock() - _request_ts;
+
+    return elapsed >= wait ? 0UL : wait - elapsed;
+}
+
+bool SampleTimer::isConverting() {
+    return _is_converting;
+}
@@ -0,0 +1,66 @@
+#ifndef KF_SAMPLETIMER_HPP
+#define KF_SAMPLETIMER_HPP
+
+#include <stdint.h>
+
+/**
+ * Sample Timer
+ *
+ * Timing of a sensor that converts in the background (DS18B20), kept free of any
+ * hardware call so it runs on the host.
+ *
+ * A conversion is requested every `sample_interval` and read back `conversion_time`
+ * later. `next()` tells how long the loop may rest without delaying either step.
+ *
+ * inside your loop()
+ *    switch (timer.poll()) {
+ *        case SampleTimer::ACTION_REQUEST: sensor.requestTemperatures(); break;
+ *        case SampleTimer::ACTION_READ:    sensor.getTempCByIndex(0); break;
+ *    }
+ */
+class SampleTimer {
+ public:
+    /** Milliseconds since boot, `millis` on the device */
+    typedef unsigned long (*Clock)();
+
+    enum Action : uint8_t {
+        ACTION_NONE = 0,
+        /** Start a conversion now */
+        ACTION_REQUEST,
+        /** The conversion is complete, read it now */
+        ACTION_READ
+    };
+
+ private:
+    Clock _clock;
+
+    unsigned long _sample_interval;
+    unsigned long _conversion_time;
+    unsigned long _request_ts;
+    bool _is_converting;
+
+ public:
+    /**
+     * @param clock Source of the elapsed milliseconds
+     * @param sample_interval Time between two conversion requests
+     * @param conversion_time Time a conversion takes
+     */
+    SampleTimer(Clock clock, unsigned long sample_interval, unsigned long conversion_time);
+
+    /** Conversion time depends on the sensor resolution, known after it is found */
+    void setConversionTime(unsigned long conversion_time);
+
+    /**
+     * Call it inside loop(), at most one action is due per call
+     *
+     * @return Action
+     */
+    Action poll();
+
+    /** Time until the next action, 0 when it is due */
+    unsigned long next();
+
+    bool isConverting();
+};
+
+#endif    // KF_SAMPLETIMER_HPP
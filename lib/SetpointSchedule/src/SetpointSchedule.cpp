@@ -0,0 +1,211 @@
+#include "SetpointSchedule.hpp"
+
+#include <EEPROM.h>
+
+const int8_t SetpointSchedule::MIN_TEMPERATURE_C;
+const int8_t SetpointSchedule::MAX_TEMPERATURE_C;
+const int8_t SetpointSchedule::MAX_THRESHOLD_C;
+
+/** 2020-01-01, any earlier clock has not been synced yet */
+static const time_t SYNCED_EPOCH = 1577836800;
+
+SetpointSchedule::SetpointSchedule()
+    : _count(0)
+    , _is_cached(false)
+    , _active(0)
+    , _valid_from(0)
+    , _valid_until(0)
+    , _latest_minute(0) {
+}
+
+bool SetpointSchedule::begin() {
+    EEPROM.begin(SCHEDULE_EEPROM_ADDRESS + sizeof(StorageHeader) + sizeof(_entries));
+
+    StorageHeader header;
+    EEPROM.get(SCHEDULE_EEPROM_ADDRESS, header);
+
+    bool is_valid = header.magic == STORAGE_MAGIC && header.count <= MAX_ENTRIES;
+    if (is_valid) {
+        for (uint8_t i = 0; i < header.count; ++i) {
+            EEPROM.get(SCHEDULE_EEPROM_ADDRESS + sizeof(StorageHeader) + i * sizeof(ScheduleEntry), _entries[i]);
+        }
+        is_valid = checksum(_entries, header.count) == header.checksum;
+    }
+
+    // the RAM copy is only needed while reading or writing
+    EEPROM.end();
+
+    _count     = is_valid ? header.count : 0;
+    _is_cached = false;
+
+    return is_valid;
+}
+
+bool SetpointSchedule::set(const ScheduleEntry *entries, uint8_t count) {
+    ScheduleEntry sorted[MAX_ENTRIES];
+    uint8_t sorted_count = 0;
+
+    // insertion sort, the table is small and mostly sorted already
+    for (uint8_t i = 0; i < count; ++i) {
+        const ScheduleEntry &entry = entries[i];
+        if (!isValid(entry)) {
+            continue;
+        }
+
+        uint8_t pos = sorted_count;
+        while (pos > 0 && sorted[pos - 1].minute > entry.minute) {
+            --pos;
+        }
+
+        if (pos > 0 && sorted[pos - 1].minute == entry.minute) {
+            sorted[pos - 1] = entry;
+            continue;
+        }
+
+        if (sorted_count == MAX_ENTRIES) {
+            continue;
+        }
+
+        memmove(&sorted[pos + 1], &sorted[pos], (sorted_count - pos) * sizeof(ScheduleEntry));
+        sorted[pos] = entry;
+        ++sorted_count;
+    }
+
+    if (sorted_count == _count && memcmp(sorted, _entries, _count * sizeof(ScheduleEntry)) == 0) {
+        return false;
+    }
+
+    memcpy(_entries, sorted, sorted_count * sizeof(ScheduleEntry));
+    _count = sorted_count;
+
+    // evaluate the new table on the next `handle()`
+    _is_cached     = false;
+    _latest_minute = 0;
+
+    store();
+    return true;
+}
+
+bool SetpointSchedule::handle(time_t now) {
+    if (now < SYNCED_EPOCH) {
+        return false;
+    }
+
+    time_t current_minute = now / 60;
+    if (current_minute == _latest_minute) {
+        return false;
+    }
+    _latest_minute = current_minute;
+
+    struct tm local;
+    localtime_r(&now, &local);
+
+    bool was_cached  = _is_cached;
+    uint8_t previous = _active;
+
+    if (lookup(toMinute(local.tm_wday, local.tm_hour, local.tm_min)) == nullptr) {
+        return false;
+    }
+
+    return !was_cached || _active != previous;
+}
+
+const ScheduleEntry *SetpointSchedule::lookup(uint16_t minute) {
+    if (_count == 0) {
+        _is_cached = false;
+        return nullptr;
+    }
+
+    if (_is_cached) {
+        bool is_inside;
+        if (_valid_from < _valid_until) {
+            is_inside = minute >= _valid_from && minute < _valid_until;
+        } else if (_valid_from > _valid_until) {
+            is_inside = minute >= _valid_from || minute < _valid_until;
+        } else {
+            // a single entry owns the whole week
+            is_inside = true;
+        }
+
+        if (is_inside) {
+            return &_entries[_active];
+        }
+    }
+
+    // first entry past the minute, the one before it is active
+    uint8_t low  = 0;
+    uint8_t high = _count;
+    while (low < high) {
+        uint8_t mid = (low + high) / 2;
+        if (_entries[mid].minute <= minute) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // before the first entry of the week, the last one of the previous week still runs
+    _active      = low == 0 ? _count - 1 : low - 1;
+    _valid_from  = _entries[_active].minute;
+    _valid_until = _entries[(_active + 1) % _count].minute;
+    _is_cached   = true;
+
+    return &_entries[_active];
+}
+
+const ScheduleEntry *SetpointSchedule::getActive() {
+    return _is_cached ? &_entries[_active] : nullptr;
+}
+
+uint8_t SetpointSchedule::size() {
+    return _count;
+}
+
+const ScheduleEntry &SetpointSchedule::at(uint8_t index) {
+    return _entries[index < _count ? index : 0];
+}
+
+uint16_t SetpointSchedule::toMinute(int day, int hour, int minute) {
+    // a part out of range would silently land on another day or time
+    if (day < 0 || day >= 7 || hour < 0 || hour >= 24 || minute < 0 || minute >= 60) {
+        return INVALID_MINUTE;
+    }
+
+    return day * MINUTES_PER_DAY + hour * 60 + minute;
+}
+
+bool SetpointSchedule::isInRange(int desired_temp_c, int desired_temp_threshold_c, int mode) {
+    return desired_temp_c >= MIN_TEMPERATURE_C && desired_temp_c <= MAX_TEMPERATURE_C && desired_temp_threshold_c >= 0
+        && desired_temp_threshold_c <= MAX_THRESHOLD_C && mode >= 0 && mode < MODE_COUNT;
+}
+
+bool SetpointSchedule::isValid(const ScheduleEntry &entry) {
+    return entry.minute < MINUTES_PER_WEEK && isInRange(entry.desired_temp_c, entry.desired_temp_threshold_c, entry.mode);
+}
+
+uint8_t SetpointSchedule::checksum(const ScheduleEntry *entries, uint8_t count) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(entries);
+    uint8_t sum          = count;
+
+    for (size_t i = 0; i < count * sizeof(ScheduleEntry); ++i) {
+        sum = (sum << 1 | sum >> 7) ^ bytes[i];
+    }
+
+    return sum;
+}
+
+void SetpointSchedule::store() {
+    StorageHeader header;
+    header.magic    = STORAGE_MAGIC;
+    header.count    = _count;
+    header.checksum = checksum(_entries, _count);
+
+    EEPROM.begin(SCHEDULE_EEPROM_ADDRESS + sizeof(StorageHeader) + sizeof(_entries));
+    EEPROM.put(SCHEDULE_EEPROM_ADDRESS, header);
+    for (uint8_t i = 0; i < _count; ++i) {
+        EEPROM.put(SCHEDULE_EEPROM_ADDRESS + sizeof(StorageHeader) + i * sizeof(ScheduleEntry), _entries[i]);
+    }
+
+    // `end()` commits the sector and frees the RAM copy
+    EEPROM.end();
+}
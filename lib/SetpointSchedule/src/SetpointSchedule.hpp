@@ -0,0 +1,163 @@
+#ifndef KF_SETPOINTSCHEDULE_HPP
+#define KF_SETPOINTSCHEDULE_HPP
+
+#include <Arduino.h>
+#include <time.h>
+
+/** EEPROM (flash emulated) address of the stored schedule */
+#ifndef SCHEDULE_EEPROM_ADDRESS
+#define SCHEDULE_EEPROM_ADDRESS 0
+#endif
+
+/**
+ * Struct ScheduleEntry
+ *
+ * From `minute` of the week until the next entry, the thermostat follows this entry.
+ * Packed to 5 bytes, the whole table fits in a single flash write.
+ */
+struct __attribute__((packed)) ScheduleEntry {
+    /** Minute of the week, 0 == Sunday 00:00, 10079 == Saturday 23:59 */
+    uint16_t minute;
+    int8_t desired_temp_c;
+    int8_t desired_temp_threshold_c;
+    /** One of `SetpointSchedule::Mode` */
+    uint8_t mode;
+};
+
+/**
+ * Setpoint Schedule
+ *
+ * Weekly schedule of setpoint, threshold and fan mode.
+ *
+ * Features:
+ * 1. Fixed size table kept sorted by minute of the week
+ * 2. Active entry lookup with a binary search, cached until the next boundary
+ * 3. Stored in flash, only written when the table actually changes
+ *
+ * inside your loop()
+ *    if (schedule.handle(time(nullptr))) {
+ *        apply(schedule.getActive())
+ *    }
+ */
+class SetpointSchedule {
+ public:
+    static const uint8_t MAX_ENTRIES       = 32;
+    static const uint16_t MINUTES_PER_DAY  = 1440;
+    static const uint16_t MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+    /** `toMinute()` result of an out of range day, hour or minute */
+    static const uint16_t INVALID_MINUTE = 0xFFFF;
+    /** Accepted setpoint and threshold, anything else is a typo rather than a room temperature */
+    static const int8_t MIN_TEMPERATURE_C = 0;
+    static const int8_t MAX_TEMPERATURE_C = 50;
+    static const int8_t MAX_THRESHOLD_C   = 20;
+
+    enum Mode : uint8_t {
+        /** Fan speed follows the temperature */
+        MODE_AUTO = 0,
+        /** Fan runs at a constant speed */
+        MODE_STATIC,
+        /** Fan is turned off */
+        MODE_OFF,
+        /** Like `MODE_AUTO`, but the fan is turned off while the room is darker than the brightness threshold */
+        MODE_AUTO_BRIGHTNESS,
+        MODE_COUNT
+    };
+
+ private:
+    static const uint32_t STORAGE_MAGIC = 0x4B465343UL;
+
+    /** Flash layout: header then `count` entries */
+    struct StorageHeader {
+        uint32_t magic;
+        uint8_t count;
+        uint8_t checksum;
+    };
+
+    ScheduleEntry _entries[MAX_ENTRIES];
+    uint8_t _count;
+
+    /**
+     * The active entry is valid while the minute of the week stays within
+     * [_valid_from, _valid_until), the range wraps around the end of the week.
+     */
+    bool _is_cached;
+    uint8_t _active;
+    uint16_t _valid_from;
+    uint16_t _valid_until;
+
+    /** Time is evaluated once per minute */
+    time_t _latest_minute;
+
+ public:
+    SetpointSchedule();
+
+    /** Copy constructor is not allowed here */
+    SetpointSchedule(const SetpointSchedule &) = delete;
+
+    /**
+     * Load the schedule stored in flash
+     *
+     * @return bool False when no valid schedule was stored
+     */
+    bool begin();
+
+    /**
+     * Replace the whole schedule, it is sorted and stored in flash when it differs.
+     *
+     * Invalid entries are dropped, a later entry replaces an earlier one on the same minute.
+     *
+     * @param entries Unsorted entries
+     * @param count Number of entries, at most `MAX_ENTRIES` are kept
+     *
+     * @return bool True when the schedule changed
+     */
+    bool set(const ScheduleEntry *entries, uint8_t count);
+
+    /**
+     * Follow the clock
+     *
+     * @param now Local epoch time, anything before 2020 means the clock is not synced yet
+     *
+     * @return bool True when another entry became active
+     */
+    bool handle(time_t now);
+
+    /**
+     * Find the entry that owns a minute of the week
+     *
+     * @return const ScheduleEntry* nullptr when the schedule is empty
+     */
+    const ScheduleEntry *lookup(uint16_t minute);
+
+    /**
+     * Entry found by the latest `handle()`
+     *
+     * @return const ScheduleEntry* nullptr when nothing is active
+     */
+    const ScheduleEntry *getActive();
+
+    uint8_t size();
+    const ScheduleEntry &at(uint8_t index);
+
+    /**
+     * Build an entry minute from a day (0 == Sunday), hour and minute
+     *
+     * @return uint16_t `INVALID_MINUTE` when any part is out of range, `set()` drops such entry
+     */
+    static uint16_t toMinute(int day, int hour, int minute);
+
+    /**
+     * Check a setpoint, threshold and mode before they are narrowed into an entry
+     *
+     * @return bool False when any of them is out of range, `set()` drops such entry
+     */
+    static bool isInRange(int desired_temp_c, int desired_temp_threshold_c, int mode);
+
+ private:
+    static bool isValid(const ScheduleEntry &entry);
+    static uint8_t checksum(const ScheduleEntry *entries, uint8_t count);
+
+    void store();
+};
+
+#endif    // KF_SETPOINTSCHEDULE_HPP
@@ -0,0 +1,41 @@
+#include "SleepWindow.hpp"
+
+const unsigned long SleepWindow::POLL_TIME;
+const unsigned long SleepWindow::MAX_SLEEP_TIME;
+
+SleepWindow::SleepWindow(Clock clock, Sleep sleep, PinRead pin_read)
+    : _clock(clock)
+    , _sleep(sleep)
+    , _pin_read(pin_read)
+    , _wake_pin(-1)
+    , _latest_wake_latency(0) {
+}
+
+void SleepWindow::begin(int8_t wake_pin) {
+    _wake_pin = wake_pin;
+}
+
+bool SleepWindow::sleep(unsigned long next_task_ms) {
+    unsigned long sleep_ms = next_task_ms < MAX_SLEEP_TIME ? next_task_ms : MAX_SLEEP_TIME;
+    unsigned long start_ms = _clock();
+    int wake_level         = _wake_pin >= 0 ? _pin_read(_wake_pin) : 0;
+
+    // every step ends on the poll time or the sleep end, whichever is first
+    while (_clock() - start_ms < sleep_ms) {
+        unsigned long poll_ms   = _clock();
+        unsigned long remaining = sleep_ms - (poll_ms - start_ms);
+        _sleep(remaining < POLL_TIME ? remaining : POLL_TIME);
+
+        if (_wake_pin >= 0 && _pin_read(_wake_pin) != wake_level) {
+            // light sleep may overshoot the poll up to the next beacon, it is the worst case
+            _latest_wake_latency = _clock() - poll_ms;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned long SleepWindow::getLastWakeLatency() {
+    return _latest_wake_latency;
+}
@@ -0,0 +1,63 @@
+#ifndef KF_SLEEPWINDOW_HPP
+#define KF_SLEEPWINDOW_HPP
+
+#include <stdint.h>
+
+/**
+ * Sleep Window
+ *
+ * One idle sleep of the Power Manager, kept free of any hardware call so it runs on the host.
+ *
+ * Features:
+ * 1. Never sleeps past the next scheduled task, nor longer than `MAX_SLEEP_TIME`
+ * 2. Ends within `POLL_TIME` after an edge of the wake pin
+ *
+ * The clock, the sleep and the pin read are injected, `millis`, `delay` and
+ * `digitalRead` on the device.
+ */
+class SleepWindow {
+ public:
+    /** Milliseconds since boot */
+    typedef unsigned long (*Clock)();
+    /** Hand the CPU over for this many milliseconds */
+    typedef void (*Sleep)(unsigned long ms);
+    /** Level of a pin */
+    typedef int (*PinRead)(uint8_t pin);
+
+    /**
+     * GPIO16 (D0) has no interrupt, so the wake pin is polled inside the sleep.
+     * A PIR pulse lasts seconds, it is never missed with this poll time.
+     */
+    static const unsigned long POLL_TIME      = 50UL;
+    static const unsigned long MAX_SLEEP_TIME = 1000UL;
+
+ private:
+    Clock _clock;
+    Sleep _sleep;
+    PinRead _pin_read;
+
+    int8_t _wake_pin;
+    unsigned long _latest_wake_latency;
+
+ public:
+    SleepWindow(Clock clock, Sleep sleep, PinRead pin_read);
+
+    /**
+     * @param wake_pin Pin that ends a sleep on any edge, -1 for timer only
+     */
+    void begin(int8_t wake_pin);
+
+    /**
+     * Sleep until the next task is due (at most `MAX_SLEEP_TIME`) or the wake pin changes
+     *
+     * @param next_task_ms Time until the next scheduled task
+     *
+     * @return bool True when the wake pin ended the sleep
+     */
+    bool sleep(unsigned long next_task_ms);
+
+    /** Upper bound of the time between the latest wake pin edge and the end of its sleep, in ms */
+    unsigned long getLastWakeLatency();
+};
+
+#endif    // KF_SLEEPWINDOW_HPP
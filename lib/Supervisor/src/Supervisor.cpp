@@ -0,0 +1,210 @@
+#include "Supervisor.hpp"
+
+extern "C" {
+#include <user_interface.h>
+}
+
+Supervisor::Supervisor()
+    : _initialized(false)
+    , _state(STATE_NORMAL)
+    , _critical_stages(0)
+    , _checked_in(0)
+    , _blocking_stages(0)
+    , _stage_started_us(0)
+    , _critical_inputs(0)
+    , _safe_duty(0)
+    , _fail_safe_callback(nullptr)
+    , _stall_timeout_s(30)
+    , _seconds_since_check_in(0)
+    , _is_suspended(false) {
+    memset(&_record, 0, sizeof(_record));
+    memset(&_last_record, 0, sizeof(_last_record));
+
+    for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+        _input_timeout[i] = 10000UL;
+        _input_latest[i]  = 0;
+    }
+}
+
+void Supervisor::begin(uint16_t critical_stages, uint8_t critical_inputs, uint16_t safe_duty, uint16_t stall_timeout_s) {
+    if (_initialized) {
+        return;
+    }
+
+    _critical_stages = critical_stages;
+    _critical_inputs = critical_inputs;
+    _safe_duty       = safe_duty;
+    _stall_timeout_s = stall_timeout_s;
+
+    ESP.rtcUserMemoryRead(SUPERVISOR_RTC_OFFSET, reinterpret_cast<uint32_t *>(&_last_record), sizeof(_last_record));
+    if (_last_record.magic != RECORD_MAGIC) {
+        memset(&_last_record, 0, sizeof(_last_record));
+    }
+
+    _record.magic        = RECORD_MAGIC;
+    _record.boot_count   = _last_record.boot_count + 1;
+    _record.reset_reason = ESP.getResetInfoPtr()->reason;
+    _record.stage        = STAGE_NONE;
+    _record.is_stalled   = false;
+    store();
+
+    // every input starts fresh, a sensor gets its timeout to deliver the first sample
+    unsigned long current_millis = millis();
+    for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+        _input_latest[i] = current_millis;
+    }
+
+    // os timer runs whenever the sketch yields, even when `loop()` never returns
+    _seconds_since_check_in = 0;
+    _guard.attach_ms(1000, &Supervisor::onGuardTick, this);
+
+    _initialized = true;
+}
+
+void Supervisor::setBlockingStages(uint16_t blocking_stages) {
+    _blocking_stages = blocking_stages;
+}
+
+void Supervisor::suspend() {
+    _is_suspended = true;
+}
+
+void Supervisor::resume() {
+    _seconds_since_check_in = 0;
+    _is_suspended           = false;
+}
+
+void Supervisor::onFailSafe(void (*callback)(uint16_t safe_duty)) {
+    _fail_safe_callback = callback;
+}
+
+void Supervisor::beginStage(uint8_t stage) {
+    if (stage >= STAGE_COUNT) {
+        return;
+    }
+
+    _record.stage     = stage;
+    _stage_started_us = micros();
+    storeStage();
+}
+
+void Supervisor::endStage(uint8_t stage) {
+    if (stage >= STAGE_COUNT) {
+        return;
+    }
+
+    _record.stage_us[stage] = micros() - _stage_started_us;
+    _record.stage           = STAGE_NONE;
+    _checked_in |= 1 << stage;
+}
+
+void Supervisor::reportInput(uint8_t input, bool is_valid) {
+    if (input >= INPUT_COUNT || !is_valid) {
+        return;
+    }
+
+    _input_latest[input] = millis();
+}
+
+bool Supervisor::isInputFresh(uint8_t input) {
+    if (input >= INPUT_COUNT) {
+        return false;
+    }
+
+    return millis() - _input_latest[input] < _input_timeout[input];
+}
+
+void Supervisor::setInputTimeout(uint8_t input, unsigned long timeout_ms) {
+    if (input < INPUT_COUNT) {
+        _input_timeout[input] = timeout_ms;
+    }
+}
+
+void Supervisor::handle() {
+    if (!_initialized) {
+        return;
+    }
+
+    evaluate();
+
+    if ((_checked_in & _critical_stages) == _critical_stages) {
+        _seconds_since_check_in = 0;
+        _checked_in             = 0;
+    }
+
+    store();
+}
+
+Supervisor::State Supervisor::getState() {
+    evaluate();
+    return _state;
+}
+
+bool Supervisor::isFailSafe() {
+    return getState() == STATE_FAIL_SAFE;
+}
+
+uint16_t Supervisor::getSafeDuty() {
+    return _safe_duty;
+}
+
+void Supervisor::setSafeDuty(uint16_t safe_duty) {
+    _safe_duty = safe_duty;
+}
+
+const Supervisor::Record &Supervisor::getRecord() {
+    return _record;
+}
+
+const Supervisor::Record &Supervisor::getLastRecord() {
+    return _last_record;
+}
+
+void Supervisor::evaluate() {
+    State state = STATE_NORMAL;
+
+    for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+        if ((_critical_inputs & (1 << i)) && !isInputFresh(i)) {
+            state = STATE_FAIL_SAFE;
+        }
+    }
+
+    _state = state;
+}
+
+void Supervisor::store() {
+    ESP.rtcUserMemoryWrite(SUPERVISOR_RTC_OFFSET, reinterpret_cast<uint32_t *>(&_record), sizeof(_record));
+}
+
+void Supervisor::storeStage() {
+    // a single block, cheap enough to run at every stage
+    uint32_t offset = SUPERVISOR_RTC_OFFSET + offsetof(Record, stage) / sizeof(uint32_t);
+    ESP.rtcUserMemoryWrite(offset, &_record.stage, sizeof(_record.stage));
+}
+
+void Supervisor::onGuardTick(Supervisor *self) {
+    // reconnects and OTA transfers block on purpose, they have their own timeouts
+    uint32_t stage = self->_record.stage;
+    if (self->_is_suspended || (stage < STAGE_COUNT && (self->_blocking_stages & (1 << stage)))) {
+        return;
+    }
+
+    uint16_t seconds = ++self->_seconds_since_check_in;
+    if (seconds < self->_stall_timeout_s) {
+        return;
+    }
+
+    // loop is stuck in a call that keeps yielding, hold the actuators safe and give it a chance
+    if (seconds < 2 * self->_stall_timeout_s) {
+        if (seconds == self->_stall_timeout_s && self->_fail_safe_callback != nullptr) {
+            self->_fail_safe_callback(self->_safe_duty);
+        }
+        return;
+    }
+
+    // still stuck, leave a trace and start over
+    self->_guard.detach();
+    self->_record.is_stalled = true;
+    self->store();
+    system_restart();
+}
@@ -0,0 +1,195 @@
+#ifndef KF_SUPERVISOR_HPP
+#define KF_SUPERVISOR_HPP
+
+#include <Arduino.h>
+#include <Ticker.h>
+
+/** First RTC user memory block (4 bytes each) used by the supervisor record */
+#ifndef SUPERVISOR_RTC_OFFSET
+#define SUPERVISOR_RTC_OFFSET 0
+#endif
+
+/**
+ * Supervisor
+ *
+ * Safety watchdog for the main loop.
+ *
+ * Features:
+ * 1. Freshness of every input, a critical input that goes stale puts the actuators in fail-safe
+ * 2. Stall guard, when the critical stages stop checking in while the SDK keeps running
+ *    the actuators get their safe value, the device restarts if the loop does not come back
+ * 3. Stages that may block on purpose (network reconnects, OTA) pause the stall guard
+ * 4. Reset reason and the latest stage timings are kept in RTC memory across reboots
+ *
+ * The core feeds the hardware watchdog on every `loop()` return and `yield()`, it only
+ * catches a loop that stops yielding. A loop stuck in a call that keeps yielding is the
+ * stall guard's job.
+ *
+ * inside your loop()
+ *    supervisor.beginStage(Supervisor::STAGE_FAN)
+ *    ... stage body ...
+ *    supervisor.endStage(Supervisor::STAGE_FAN)
+ *    ...
+ *    supervisor.handle()
+ */
+class Supervisor {
+ public:
+    enum Stage : uint8_t {
+        STAGE_NETWORK = 0,
+        STAGE_TEMPERATURE,
+        STAGE_LDR,
+        STAGE_PIR,
+        STAGE_FAN,
+        STAGE_LCD,
+        STAGE_COUNT,
+        STAGE_NONE = 0xFF
+    };
+
+    enum Input : uint8_t {
+        INPUT_TEMPERATURE = 0,
+        INPUT_LDR,
+        INPUT_PIR,
+        INPUT_COUNT
+    };
+
+    enum State : uint8_t {
+        STATE_NORMAL = 0,
+        /** A critical input went stale, actuators run on their safe values */
+        STATE_FAIL_SAFE
+    };
+
+    /**
+     * Survives any reset but a power loss. Every field is 4 bytes aligned
+     * since RTC memory is written by blocks.
+     */
+    struct Record {
+        uint32_t magic;
+        uint32_t boot_count;
+        /** `rst_info::reason` of the boot that owns this record */
+        uint32_t reset_reason;
+        /** Stage running when the record was written, `STAGE_NONE` between loops */
+        uint32_t stage;
+        /** True when the stall guard restarted the device */
+        uint32_t is_stalled;
+        /** Latest duration of each stage in microseconds */
+        uint32_t stage_us[STAGE_COUNT];
+    };
+
+ private:
+    static const uint32_t RECORD_MAGIC = 0x4B465356UL;
+
+    bool _initialized;
+    State _state;
+
+    /** Current and previous boot records */
+    Record _record;
+    Record _last_record;
+
+    /** Stages that must check in to reset the stall guard */
+    uint16_t _critical_stages;
+    uint16_t _checked_in;
+    /** Stages allowed to block, the stall guard pauses while one of them runs */
+    uint16_t _blocking_stages;
+    unsigned long _stage_started_us;
+
+    /** Inputs that put the actuators in fail-safe when they go stale */
+    uint8_t _critical_inputs;
+    unsigned long _input_timeout[INPUT_COUNT];
+    unsigned long _input_latest[INPUT_COUNT];
+
+    uint16_t _safe_duty;
+    /** Drive the actuators from the stall guard, the loop is not running there */
+    void (*_fail_safe_callback)(uint16_t safe_duty);
+
+    /**
+     * Actuators get their safe value once the critical stages have not checked in
+     * for `_stall_timeout_s`, the device restarts after another `_stall_timeout_s`.
+     */
+    Ticker _guard;
+    uint16_t _stall_timeout_s;
+    volatile uint16_t _seconds_since_check_in;
+    volatile bool _is_suspended;
+
+ public:
+    Supervisor();
+
+    /** Copy constructor is not allowed here */
+    Supervisor(const Supervisor &) = delete;
+
+    /**
+     * Load the previous record from RTC memory and start the stall guard
+     *
+     * @param critical_stages Bitmask of `Stage` that must check in to reset the stall guard
+     * @param critical_inputs Bitmask of `Input` that trigger the fail-safe state
+     * @param safe_duty Actuator value to use while in fail-safe
+     * @param stall_timeout_s Fail-safe after this long without a check-in, restart after twice as long
+     */
+    void begin(uint16_t critical_stages, uint8_t critical_inputs, uint16_t safe_duty, uint16_t stall_timeout_s = 30);
+
+    /**
+     * Stages that may block for long on purpose, e.g. the network stage while it
+     * reconnects. The stall guard does not count while one of them runs.
+     *
+     * @param blocking_stages Bitmask of `Stage`
+     */
+    void setBlockingStages(uint16_t blocking_stages);
+
+    /**
+     * Pause the stall guard around a long task that runs outside the stages' control,
+     * e.g. an OTA update. `resume()` restarts the count from zero.
+     */
+    void suspend();
+    void resume();
+
+    /**
+     * Called from the stall guard with the safe duty once the loop stalls.
+     * It runs in the timer context, keep it short and non-blocking.
+     */
+    void onFailSafe(void (*callback)(uint16_t safe_duty));
+
+    /** Mark the start of a loop stage */
+    void beginStage(uint8_t stage);
+
+    /** Mark the end of a loop stage, it counts as a check-in */
+    void endStage(uint8_t stage);
+
+    /**
+     * Report a fresh sample of an input
+     *
+     * @param input One of `Input`
+     * @param is_valid False when the sensor returned an error value
+     */
+    void reportInput(uint8_t input, bool is_valid);
+
+    /** Check whether an input had a valid sample within its timeout */
+    bool isInputFresh(uint8_t input);
+
+    /** Override the default 10s freshness timeout of an input */
+    void setInputTimeout(uint8_t input, unsigned long timeout_ms);
+
+    /**
+     * Call it at the end of every loop. It updates the state, resets the stall guard
+     * when every critical stage checked in and stores the record.
+     */
+    void handle();
+
+    State getState();
+    bool isFailSafe();
+
+    uint16_t getSafeDuty();
+    void setSafeDuty(uint16_t safe_duty);
+
+    /** Record of this boot */
+    const Record &getRecord();
+    /** Record left by the previous boot, `magic` is zero when there was none */
+    const Record &getLastRecord();
+
+ private:
+    void evaluate();
+    void store();
+    void storeStage();
+
+    static void onGuardTick(Supervisor *self);
+};
+
+#endif    // KF_SUPERVISOR_HPP
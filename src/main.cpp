@@ -1,4 +1,6 @@
 #include <Arduino.h>
+#include <ArduinoOTA.h>
+#include <BinLog.h>
 #include <DallasTemperature.h>
 #include <OTAHandler.h>
 #include <OneWire.h>
@@ -6,6 +8,11 @@
 
 #include <FanController.hpp>
 #include <LCDController.hpp>
+#include <PowerManager.hpp>
+#include <PropertySync.hpp>
+#include <SampleTimer.hpp>
+#include <SetpointSchedule.hpp>
+#include <Supervisor.hpp>
 
 /** -------------------------------------- Definitions ------------------------------------- */
 #ifndef SSID_NAME
@@ -24,6 +31,39 @@
 #ifndef THINGER_DEVICE_CREDS
 #define THINGER_DEVICE_CREDS ""
 #endif
+/** Property that holds `fan_state`, `lcd_state` and `schedule`, created from those legacy properties when missing */
+#ifndef THINGER_STATE_PROPERTY
+#define THINGER_STATE_PROPERTY "device_state"
+#endif
+
+/** Fan duty while the temperature sensor is lost */
+#ifndef SAFE_FAN_DUTY
+#define SAFE_FAN_DUTY FanController::FanSpeed::FAN_NORMAL
+#endif
+/** Fan goes to its safe duty once the loop stops checking in for this many seconds, the device restarts after twice as long */
+#ifndef SUPERVISOR_STALL_TIMEOUT
+#define SUPERVISOR_STALL_TIMEOUT 30
+#endif
+
+/** Radio sleep used while the fan is off and the room is empty */
+#ifndef POWER_IDLE_MODE
+#define POWER_IDLE_MODE PowerManager::MODE_LIGHT_SLEEP
+#endif
+
+/** POSIX timezone of the schedule, e.g. "WIB-7" */
+#ifndef SCHEDULE_TZ
+#define SCHEDULE_TZ "UTC0"
+#endif
+#ifndef NTP_SERVER
+#define NTP_SERVER "pool.ntp.org"
+#endif
+
+/** Binary log goes to Serial unless a UDP host is given */
+#ifndef BINLOG_UDP_PORT
+#define BINLOG_UDP_PORT 9000
+#endif
+/** Report loops slower than this, in microseconds */
+static const unsigned long LOOP_SLOW_US = 100000UL;
 
 /** ----------------------------------------- Pins ----------------------------------------- */
 static const uint8_t PIN_LDR         = A0;
@@ -32,16 +72,29 @@ static const uint8_t PIN_TEMPERATURE = D7;
 static const uint8_t PIN_FAN_INA     = D5;
 static const uint8_t PIN_FAN_INB     = D6;
 
+/** PWM pin for the LCD backlight LED, -1 keeps it on the I2C backpack */
+#ifndef PIN_LCD_BACKLIGHT
+#define PIN_LCD_BACKLIGHT -1
+#endif
+
 /** ----------------------------------- Library Instance ----------------------------------- */
 ThingerESP8266 thing(THINGER_USERNAME, THINGER_DEVICE_ID, THINGER_DEVICE_CREDS);
+PropertySync property_sync(thing, THINGER_STATE_PROPERTY);
 OneWire one_wire(PIN_TEMPERATURE);
 DallasTemperature sensor_temperature(&one_wire);
 LCDController lcd_controller;
 FanController fan_controller;
+Supervisor supervisor;
+PowerManager power_manager;
+SetpointSchedule setpoint_schedule;
+/** Conversion runs in the background, a sample is taken every 2s */
+SampleTimer temperature_timer(millis, 2000UL, 750UL);
 
 /** ---------------------------------------- States ---------------------------------------- */
 struct TemperatureSensorState {
+    /** Latest valid reading, it is kept while the sensor is lost */
     float temperature_c = 0.0F;
+    bool is_valid       = false;
 } temperature_state;
 
 struct LDRState {
@@ -78,29 +131,82 @@ struct FanState {
 
 /** --------------------------------------- Internal --------------------------------------- */
 static bool initSynchronize = false;
-void synchronizeFanProperties();
-void synchronizeLCDProperties();
+void synchronizeScheduleProperties(pson &schedule_props);
+void applyProperties();
+void applyFanState();
 
 inline void updateTemperatureSensor();
 inline void updateLDR();
 inline void updatePIR();
+inline void handleSchedule();
 inline void handleFanController();
 inline void handleLCDController();
 
 void setup() {
+    /** Diagnostics, decode with `tools/binlog_decode.py` */
+#ifdef BINLOG_UDP_HOST
+    BinLog.beginUdp(BINLOG_UDP_HOST, BINLOG_UDP_PORT);
+#else
+    Serial.begin(115200);
+    BinLog.beginSerial(Serial);
+#endif
+    BLOG("boot, reset reason %u", ESP.getResetInfoPtr()->reason);
+
+    /** Watch the loop before anything else can hang it */
+    supervisor.begin((1 << Supervisor::STAGE_TEMPERATURE) | (1 << Supervisor::STAGE_FAN),
+                     1 << Supervisor::INPUT_TEMPERATURE,
+                     SAFE_FAN_DUTY,
+                     SUPERVISOR_STALL_TIMEOUT);
+    supervisor.setBlockingStages(1 << Supervisor::STAGE_NETWORK);
+    supervisor.onFailSafe([](uint16_t safe_duty) -> void {
+        if (fan_controller.isFanActive()) {
+            analogWrite(PIN_FAN_INA, safe_duty);
+            analogWrite(PIN_FAN_INB, 0);
+        }
+    });
+
     /** Setup connections */
     thing.add_wifi(SSID_NAME, SSID_PSK);
     OTAHandler.begin(false);
 
+    /** An OTA transfer runs inside a single loop, keep the stall guard away from it */
+    ArduinoOTA.onStart([]() -> void {
+        supervisor.suspend();
+    });
+    ArduinoOTA.onEnd([]() -> void {
+        supervisor.resume();
+    });
+    ArduinoOTA.onError([](ota_error_t error) -> void {
+        BLOG("ota error %u", error);
+        supervisor.resume();
+    });
+
+    configTime(SCHEDULE_TZ, NTP_SERVER);
+
     /** Initialize sensors and pins */
     sensor_temperature.begin();
+    sensor_temperature.setWaitForConversion(false);
+    temperature_timer.setConversionTime(sensor_temperature.millisToWaitForConversion(sensor_temperature.getResolution()));
 
     /** Part of PIR system */
     pinMode(PIN_PIR, INPUT);
     pinMode(BUILTIN_LED, OUTPUT);
 
-    lcd_controller.begin();
+    power_manager.begin(POWER_IDLE_MODE, PIN_PIR);
+    lcd_controller.begin(PIN_LCD_BACKLIGHT);
     fan_controller.begin(fan_state.desired_temp_c, fan_state.desired_temp_threshold_c);
+    setpoint_schedule.begin();
+
+    /** Device states shared with the cloud, local changes are written back */
+    property_sync.bind("fan_state", "motor_active", &fan_state.motor_active);
+    property_sync.bind("fan_state", "motor_static_mode", &fan_state.motor_static_mode);
+    property_sync.bind("fan_state", "motor_off_brightness", &fan_state.motor_off_brightness);
+    property_sync.bind("fan_state", "motor_off_brightness_precentage", &fan_state.motor_off_brightness_precentage);
+    property_sync.bind("fan_state", "desired_temperature", &fan_state.desired_temp_c);
+    property_sync.bind("fan_state", "desired_temperature_threshold", &fan_state.desired_temp_threshold_c);
+    property_sync.bind("lcd_state", "backlight", &lcd_state.backlight);
+    property_sync.onApply(applyProperties);
+    property_sync.onSection("schedule", synchronizeScheduleProperties);
 
     /** Expose public states to cloud */
     thing["sensor_values"] >> [](pson &out) -> void {
@@ -113,70 +219,194 @@ void setup() {
         out["has_living_object"] = pir_state.has_living_object;
     };
 
+    thing["supervisor"] >> [](pson &out) -> void {
+        const Supervisor::Record &record      = supervisor.getRecord();
+        const Supervisor::Record &last_record = supervisor.getLastRecord();
+
+        out["fail_safe"]    = supervisor.isFailSafe();
+        out["boot_count"]   = record.boot_count;
+        out["reset_reason"] = ESP.getResetReason().c_str();
+        out["last_stalled"] = (bool) last_record.is_stalled;
+        out["last_stage"]   = last_record.stage;
+
+        pson_array &stage_us = out["last_stage_us"];
+        for (uint8_t i = 0; i < Supervisor::STAGE_COUNT; ++i) {
+            stage_us.add(last_record.stage_us[i]);
+        }
+    };
+
+    thing["power"] >> [](pson &out) -> void {
+        const PowerManager::Record &record = power_manager.getRecord();
+
+        out["mode"]               = (uint8_t) power_manager.getMode();
+        out["duty_cycle"]         = power_manager.getDutyCycle();
+        out["average_current_ma"] = power_manager.getAverageCurrent();
+        out["wake_latency_ms"]    = power_manager.getLastWakeLatency();
+        out["pir_wakes"]          = record.pin_wakes;
+        out["timer_wakes"]        = record.timer_wakes;
+    };
+
     thing["sync"] = []() -> void {
-        synchronizeFanProperties();
-        synchronizeLCDProperties();
+        property_sync.fetch();
     };
 }
 
 void loop() {
+    unsigned long loop_started_us = micros();
+
     /** Internet activities */
+    supervisor.beginStage(Supervisor::STAGE_NETWORK);
     OTAHandler.handle();
     thing.handle();
 
+    if (!initSynchronize) {
+        property_sync.fetch();
+
+        initSynchronize = true;
+    }
+    property_sync.handle();
+    supervisor.endStage(Supervisor::STAGE_NETWORK);
+
     /** Sensors, actuators, display */
+    supervisor.beginStage(Supervisor::STAGE_TEMPERATURE);
     updateTemperatureSensor();
+    supervisor.endStage(Supervisor::STAGE_TEMPERATURE);
+
+    supervisor.beginStage(Supervisor::STAGE_LDR);
     updateLDR();
+    supervisor.endStage(Supervisor::STAGE_LDR);
+
+    supervisor.beginStage(Supervisor::STAGE_PIR);
     updatePIR();
+    supervisor.endStage(Supervisor::STAGE_PIR);
+
+    supervisor.beginStage(Supervisor::STAGE_FAN);
+    handleSchedule();
     handleFanController();
+    supervisor.endStage(Supervisor::STAGE_FAN);
+
+    supervisor.beginStage(Supervisor::STAGE_LCD);
     handleLCDController();
+    supervisor.endStage(Supervisor::STAGE_LCD);
 
-    if (!initSynchronize) {
-        synchronizeFanProperties();
-        synchronizeLCDProperties();
+    supervisor.handle();
 
-        initSynchronize = true;
+    unsigned long loop_us = micros() - loop_started_us;
+    if (loop_us > LOOP_SLOW_US) {
+        BLOG("slow loop %u us", loop_us);
     }
+    BinLog.handle();
+
+    /** Rest until the next sample while nothing is running and nobody is around */
+    bool is_idle = fan_state.speed == FanController::FanSpeed::FAN_OFF && !pir_state.has_living_object;
+    power_manager.handle(is_idle, temperature_timer.next());
 }
 
-void synchronizeFanProperties() {
-    pson fan_props;
-    thing.get_property("fan_state", fan_props);
-    fan_state.motor_active                    = (bool) fan_props["motor_active"];
-    fan_state.motor_static_mode               = (bool) fan_props["motor_static_mode"];
-    fan_state.motor_off_brightness            = (bool) fan_props["motor_off_brightness"];
-    fan_state.motor_off_brightness_precentage = (uint8_t) fan_props["motor_off_brightness_precentage"];
-    fan_state.desired_temp_c                  = (int8_t) fan_props["desired_temperature"];
-    fan_state.desired_temp_threshold_c        = (int8_t) fan_props["desired_temperature_threshold"];
+void applyProperties() {
+    applyFanState();
 
+    lcd_controller.setBlacklightOn(lcd_state.backlight);
+    handleLCDController();
+}
+
+/**
+ * Schedule section of the state property, read by the same fetch as the other sections:
+ * { "entries": [ { "day": 0-6 (0 == Sunday), "hour": 0-23, "minute": 0-59, "temperature", "threshold", "mode" } ] }
+ *
+ * `day`, `hour`, `minute`, `temperature` and `threshold` are required, an entry without them or out of range is dropped.
+ * `temperature`: 0-50, `threshold`: 0-20, both in degree.
+ * `mode`: 0 auto, 1 static, 2 off, 3 auto and off below the brightness threshold.
+ * An entry sets `motor_off_brightness` too (on for mode 3 only), so the brightness rule
+ * never overrides a scheduled mode. A cloud edit applies until the next entry.
+ */
+void synchronizeScheduleProperties(pson &schedule_props) {
+    /** Keep the stored schedule when the entries are missing */
+    pson &items_value = schedule_props["entries"];
+    if (!items_value.is_array()) {
+        return;
+    }
+
+    ScheduleEntry entries[SetpointSchedule::MAX_ENTRIES];
+    uint8_t count = 0;
+
+    pson_array &items = items_value;
+    for (pson_array::iterator it = items.begin(); it.valid() && count < SetpointSchedule::MAX_ENTRIES; it.next()) {
+        pson &item = it.item();
+
+        /** A missing key reads as 0, that is Sunday 00:00, a 0 degree setpoint or a 0 degree threshold */
+        if (!item["day"].is_number() || !item["hour"].is_number() || !item["minute"].is_number() || !item["temperature"].is_number()
+            || !item["threshold"].is_number()) {
+            continue;
+        }
+
+        uint16_t minute = SetpointSchedule::toMinute((int) item["day"], (int) item["hour"], (int) item["minute"]);
+        if (minute == SetpointSchedule::INVALID_MINUTE) {
+            continue;
+        }
+
+        /** Checked before the narrowing cast, 300 would otherwise wrap to a valid 44 */
+        int desired_temp_c           = item["temperature"];
+        int desired_temp_threshold_c = item["threshold"];
+        int mode                     = item["mode"];
+        if (!SetpointSchedule::isInRange(desired_temp_c, desired_temp_threshold_c, mode)) {
+            continue;
+        }
+
+        entries[count].minute                   = minute;
+        entries[count].desired_temp_c           = desired_temp_c;
+        entries[count].desired_temp_threshold_c = desired_temp_threshold_c;
+        entries[count].mode                     = mode;
+        ++count;
+    }
+
+    setpoint_schedule.set(entries, count);
+}
+
+void applyFanState() {
     fan_controller.setFanActive(fan_state.motor_active);
     fan_controller.setStaticMode(fan_state.motor_static_mode);
     fan_controller.setDesiredTemperature(fan_state.desired_temp_c);
     fan_controller.setDesiredTemperatureThreshold(fan_state.desired_temp_threshold_c);
 }
 
-void synchronizeLCDProperties() {
-    pson lcd_props;
-    thing.get_property("lcd_state", lcd_props);
-    lcd_state.backlight = (bool) lcd_props["backlight"];
+inline void updateTemperatureSensor() {
+    switch (temperature_timer.poll()) {
+        case SampleTimer::ACTION_REQUEST:
+            sensor_temperature.requestTemperaturesByIndex(0);
+            return;
+        case SampleTimer::ACTION_READ:
+            break;
+        case SampleTimer::ACTION_NONE:
+        default:
+            return;
+    }
+
+    float temperature_c = sensor_temperature.getTempCByIndex(0);
 
-    lcd_controller.setBlacklightOn(lcd_state.backlight);
-    lcd_controller.update(temperature_state.temperature_c, fan_controller.getFanSpeedIndicator());
-}
+    temperature_state.is_valid = temperature_c != DEVICE_DISCONNECTED_C;
+    if (temperature_state.is_valid) {
+        temperature_state.temperature_c = temperature_c;
+    }
+    supervisor.reportInput(Supervisor::INPUT_TEMPERATURE, temperature_state.is_valid);
 
-inline void updateTemperatureSensor() {
-    sensor_temperature.requestTemperaturesByIndex(0);
-    temperature_state.temperature_c = sensor_temperature.getTempCByIndex(0);
+    BLOG("temperature %.2f valid %u", temperature_c, temperature_state.is_valid);
 }
 
 inline void updateLDR() {
     ldr_state.resistance        = analogRead(PIN_LDR);
     ldr_state.resistance_mapped = max<uint16_t>(0, min<uint16_t>(ldr_state.resistance, 1000));
     ldr_state.precentage        = static_cast<uint8_t>(ldr_state.resistance_mapped / 10);
+
+    supervisor.reportInput(Supervisor::INPUT_LDR, true);
 }
 
 inline void updatePIR() {
+    bool had_living_object      = pir_state.has_living_object;
     pir_state.has_living_object = digitalRead(PIN_PIR) == HIGH;
+    if (pir_state.has_living_object != had_living_object) {
+        BLOG("pir %u", pir_state.has_living_object);
+    }
+    supervisor.reportInput(Supervisor::INPUT_PIR, true);
 
     pir_state.update_curr_ts = millis();
     bool allow_to_update     = pir_state.update_curr_ts - pir_state.update_last_ts > pir_state.UPDATE_INTERVAL;
@@ -193,17 +423,58 @@ inline void updatePIR() {
     }
 }
 
+inline void handleSchedule() {
+    /** Only a boundary applies an entry, cloud edits stay until the next one */
+    if (!setpoint_schedule.handle(time(nullptr))) {
+        return;
+    }
+
+    const ScheduleEntry *entry = setpoint_schedule.getActive();
+    BLOG("schedule entry %u: setpoint %d threshold %d mode %u", entry->minute, entry->desired_temp_c, entry->desired_temp_threshold_c, entry->mode);
+
+    /** The brightness rule would recompute `motor_active` right away, the entry decides whether it runs */
+    fan_state.motor_off_brightness     = entry->mode == SetpointSchedule::MODE_AUTO_BRIGHTNESS;
+    fan_state.motor_active             = entry->mode != SetpointSchedule::MODE_OFF;
+    fan_state.motor_static_mode        = entry->mode == SetpointSchedule::MODE_STATIC;
+    fan_state.desired_temp_c           = entry->desired_temp_c;
+    fan_state.desired_temp_threshold_c = entry->desired_temp_threshold_c;
+
+    applyFanState();
+}
+
 inline void handleFanController() {
     if (fan_state.motor_off_brightness) {
         fan_state.motor_active = ldr_state.precentage <= fan_state.motor_off_brightness_precentage ? false : true;
         fan_controller.setFanActive(fan_state.motor_active);
     }
 
-    fan_state.speed = fan_controller.getFanSpeed(temperature_state.temperature_c);
+    uint16_t previous_speed = fan_state.speed;
+    fan_state.speed         = fan_controller.getFanSpeed(temperature_state.temperature_c);
+
+    /** Temperature is unknown, keep the air moving unless the user turned the fan off */
+    if (supervisor.isFailSafe() && fan_controller.isFanActive()) {
+        fan_state.speed = supervisor.getSafeDuty();
+    }
+
+    if (fan_state.speed != previous_speed) {
+        BLOG("fan speed %u -> %u, fail-safe %u", previous_speed, fan_state.speed, supervisor.isFailSafe());
+    }
+
     analogWrite(PIN_FAN_INA, fan_state.speed);
     analogWrite(PIN_FAN_INB, 0);
 }
 
 inline void handleLCDController() {
-    lcd_controller.update(temperature_state.temperature_c, fan_controller.getFanSpeedIndicator());
+    LCDData lcd_data;
+    lcd_data.temperature_c            = temperature_state.temperature_c;
+    lcd_data.is_fail_safe             = supervisor.isFailSafe();
+    lcd_data.fan_speed                = FanController::toFanSpeedIndicator(fan_state.speed);
+    lcd_data.desired_temp_c           = fan_state.desired_temp_c;
+    lcd_data.desired_temp_threshold_c = fan_state.desired_temp_threshold_c;
+    lcd_data.ldr_precentage           = ldr_state.precentage;
+    lcd_data.has_living_object        = pir_state.has_living_object;
+    lcd_data.is_wifi_connected        = WiFi.status() == WL_CONNECTED;
+    lcd_data.is_cloud_connected       = thing.is_connected();
+
+    lcd_controller.update(lcd_data);
 }
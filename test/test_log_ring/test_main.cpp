@@ -0,0 +1,162 @@
+#include <LogRing.hpp>
+#include <string.h>
+#include <unity.h>
+
+static const uint32_t BUFFER_WORDS = 16;
+static const uint32_t FMT          = 0x40200000UL;
+
+static volatile uint32_t buffer[BUFFER_WORDS];
+static unsigned long fake_micros = 0;
+
+/** Record pushed from inside the critical section hook, like an ISR right after a reservation */
+static LogRing *nested_ring  = nullptr;
+static bool is_nested_armed  = false;
+static uint8_t nested_peek   = 0xFF;
+static uint32_t enter_depth  = 0;
+static uint32_t leave_states = 0;
+
+static unsigned long fakeMicros() {
+    return ++fake_micros;
+}
+
+static uint32_t fakeEnter() {
+    return ++enter_depth;
+}
+
+static void fakeLeave(uint32_t state) {
+    TEST_ASSERT_EQUAL_UINT32(enter_depth, state);
+    --enter_depth;
+    ++leave_states;
+
+    if (is_nested_armed) {
+        is_nested_armed = false;
+
+        const uint32_t args[1] = {0xBEEF};
+        nested_ring->push(FMT + 4, args, 1);
+        // the outer record is reserved first but still unpublished
+        nested_peek = nested_ring->peek();
+    }
+}
+
+/** Pop a record and check its frame, return its first argument */
+static uint32_t popRecord(LogRing &ring, uint32_t fmt, uint8_t count) {
+    uint8_t frame[2 + (LogRing::RECORD_WORDS + 8) * 4];
+    uint32_t words = LogRing::RECORD_WORDS + count;
+
+    TEST_ASSERT_EQUAL_UINT8(words, ring.peek());
+    TEST_ASSERT_EQUAL_UINT32(2 + words * 4, ring.pop(frame));
+    TEST_ASSERT_EQUAL_UINT8(LogRing::FRAME_SYNC_0, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8(LogRing::FRAME_SYNC_1, frame[1]);
+
+    uint32_t record[LogRing::RECORD_WORDS + 8];
+    memcpy(record, frame + 2, words * 4);
+
+    TEST_ASSERT_EQUAL_UINT32(LogRing::HEADER_MAGIC | words << 8 | static_cast<uint32_t>(count) << 16, record[0]);
+    TEST_ASSERT_EQUAL_UINT32(fmt, record[1]);
+
+    return count > 0 ? record[LogRing::RECORD_WORDS] : 0;
+}
+
+void setUp() {
+    fake_micros     = 0;
+    nested_ring     = nullptr;
+    is_nested_armed = false;
+    nested_peek     = 0xFF;
+    enter_depth     = 0;
+    leave_states    = 0;
+}
+
+void tearDown() {
+}
+
+void test_records_survive_wraparound() {
+    LogRing ring(buffer, BUFFER_WORDS, fakeMicros, fakeEnter, fakeLeave);
+
+    // 5 words records do not divide the buffer, they straddle its end every few rounds
+    for (uint32_t i = 0; i < 100; ++i) {
+        const uint32_t args[2] = {i, ~i};
+        ring.push(FMT, args, 2);
+        ring.push(FMT, args, 2);
+
+        TEST_ASSERT_EQUAL_UINT32(i, popRecord(ring, FMT, 2));
+        TEST_ASSERT_EQUAL_UINT32(i, popRecord(ring, FMT, 2));
+        TEST_ASSERT_EQUAL_UINT8(0, ring.peek());
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(200, leave_states);
+}
+
+void test_full_buffer_drops_and_counts() {
+    LogRing ring(buffer, BUFFER_WORDS, fakeMicros, fakeEnter, fakeLeave);
+    const uint32_t args[1] = {1};
+
+    // 4 words each, the fifth one does not fit
+    for (uint8_t i = 0; i < 4; ++i) {
+        ring.push(FMT, args, 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getDropped());
+
+    ring.push(FMT, args, 1);
+    ring.push(FMT, nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, ring.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(0, enter_depth);
+
+    // room again once a record is drained
+    popRecord(ring, FMT, 1);
+    ring.push(FMT + 8, nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, ring.getDropped());
+
+    for (uint8_t i = 0; i < 3; ++i) {
+        popRecord(ring, FMT, 1);
+    }
+    popRecord(ring, FMT + 8, 0);
+}
+
+void test_nested_writer_keeps_reservation_order() {
+    LogRing ring(buffer, BUFFER_WORDS, fakeMicros, fakeEnter, fakeLeave);
+    nested_ring     = &ring;
+    is_nested_armed = true;
+
+    const uint32_t args[1] = {0xCAFE};
+    ring.push(FMT, args, 1);
+
+    // the drain stopped at the unpublished outer record, not skipping to the complete nested one
+    TEST_ASSERT_EQUAL_UINT8(0, nested_peek);
+
+    TEST_ASSERT_EQUAL_UINT32(0xCAFE, popRecord(ring, FMT, 1));
+    TEST_ASSERT_EQUAL_UINT32(0xBEEF, popRecord(ring, FMT + 4, 1));
+    TEST_ASSERT_EQUAL_UINT8(0, ring.peek());
+}
+
+void test_released_words_never_pass_as_published() {
+    LogRing ring(buffer, BUFFER_WORDS, fakeMicros, fakeEnter, fakeLeave);
+    const uint32_t args[1] = {7};
+
+    // a full round, the next reservation lands on the header of the first record
+    for (uint8_t i = 0; i < 4; ++i) {
+        ring.push(FMT, args, 1);
+        popRecord(ring, FMT, 1);
+    }
+
+    for (uint32_t i = 0; i < BUFFER_WORDS; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(0, buffer[i]);
+    }
+
+    nested_ring     = &ring;
+    is_nested_armed = true;
+    ring.push(FMT + 12, nullptr, 0);
+
+    TEST_ASSERT_EQUAL_UINT8(0, nested_peek);
+    popRecord(ring, FMT + 12, 0);
+    TEST_ASSERT_EQUAL_UINT32(0xBEEF, popRecord(ring, FMT + 4, 1));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_survive_wraparound);
+    RUN_TEST(test_full_buffer_drops_and_counts);
+    RUN_TEST(test_nested_writer_keeps_reservation_order);
+    RUN_TEST(test_released_words_never_pass_as_published);
+    return UNITY_END();
+}
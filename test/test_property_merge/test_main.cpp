@@ -0,0 +1,93 @@
+#include <PropertyMerge.hpp>
+#include <unity.h>
+
+/** Two sections: fan_state holds fields 0 and 1, lcd_state holds field 2 */
+static MergeField fields[3];
+
+static void bindFields(int16_t active, int16_t temperature, int16_t backlight) {
+    fields[0] = {0, active, active, active};
+    fields[1] = {0, temperature, temperature, temperature};
+    fields[2] = {2, backlight, backlight, backlight};
+}
+
+void setUp() {
+    bindFields(1, 28, 0);
+}
+
+void tearDown() {
+}
+
+void test_nothing_changed_is_clean() {
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_NONE, PropertyMerge::merge(fields, 3, false));
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_NONE, PropertyMerge::merge(fields, 3, true));
+}
+
+void test_local_change_is_written() {
+    fields[1].value = 24;
+
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_DIRTY, PropertyMerge::merge(fields, 3, false));
+    TEST_ASSERT_EQUAL_INT16(24, fields[1].value);
+    TEST_ASSERT_EQUAL_INT16(24, fields[1].base);
+}
+
+void test_dashboard_edit_merges_field_by_field() {
+    // same version, the dashboard edited the setpoint while the fan was turned off here
+    fields[0].value = 0;
+    fields[1].cloud = 22;
+
+    uint8_t result = PropertyMerge::merge(fields, 3, false);
+
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_APPLIED | PropertyMerge::RESULT_DIRTY, result);
+    TEST_ASSERT_EQUAL_INT16(0, fields[0].value);
+    TEST_ASSERT_EQUAL_INT16(22, fields[1].value);
+}
+
+void test_newer_edit_takes_the_section_whatever_the_field_order() {
+    // the newer writer edited the first field, the local change is on the second one
+    fields[0].cloud = 0;
+    fields[1].value = 24;
+
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_APPLIED, PropertyMerge::merge(fields, 3, true));
+    TEST_ASSERT_EQUAL_INT16(0, fields[0].value);
+    TEST_ASSERT_EQUAL_INT16(28, fields[1].value);
+
+    // and the other way around
+    bindFields(1, 28, 0);
+    fields[0].value = 0;
+    fields[1].cloud = 20;
+
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_APPLIED, PropertyMerge::merge(fields, 3, true));
+    TEST_ASSERT_EQUAL_INT16(1, fields[0].value);
+    TEST_ASSERT_EQUAL_INT16(20, fields[1].value);
+}
+
+void test_newer_edit_keeps_other_sections() {
+    fields[1].cloud = 20;
+    fields[2].value = 1;
+
+    uint8_t result = PropertyMerge::merge(fields, 3, true);
+
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_APPLIED | PropertyMerge::RESULT_DIRTY, result);
+    TEST_ASSERT_EQUAL_INT16(20, fields[1].value);
+    TEST_ASSERT_EQUAL_INT16(1, fields[2].value);
+    TEST_ASSERT_EQUAL_INT16(1, fields[2].base);
+}
+
+void test_same_change_on_both_sides_is_clean() {
+    fields[1].value = 24;
+    fields[1].cloud = 24;
+
+    TEST_ASSERT_EQUAL_UINT8(PropertyMerge::RESULT_NONE, PropertyMerge::merge(fields, 3, true));
+    TEST_ASSERT_EQUAL_INT16(24, fields[1].base);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_changed_is_clean);
+    RUN_TEST(test_local_change_is_written);
+    RUN_TEST(test_dashboard_edit_merges_field_by_field);
+    RUN_TEST(test_newer_edit_takes_the_section_whatever_the_field_order);
+    RUN_TEST(test_newer_edit_keeps_other_sections);
+    RUN_TEST(test_same_change_on_both_sides_is_clean);
+    return UNITY_END();
+}
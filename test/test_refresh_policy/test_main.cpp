@@ -0,0 +1,159 @@
+#include <RefreshPolicy.hpp>
+#include <limits.h>
+#include <unity.h>
+
+/** Simulated `millis()`, every test moves it by hand */
+static unsigned long fake_millis = 0;
+
+static unsigned long fakeClock() {
+    return fake_millis;
+}
+
+/** Compose every `step` ms for `duration` ms with an unchanged frame, return the repaint count */
+static uint8_t idleFor(RefreshPolicy &policy, unsigned long duration, unsigned long step, unsigned long *latest_repaint) {
+    uint8_t repaints = 0;
+
+    for (unsigned long elapsed = 0; elapsed < duration; elapsed += step) {
+        fake_millis += step;
+
+        if (policy.isComposeDue() && policy.commit(false) == RefreshPolicy::ACTION_REPAINT) {
+            *latest_repaint = fake_millis;
+            ++repaints;
+        }
+    }
+
+    return repaints;
+}
+
+void setUp() {
+    fake_millis = 0;
+}
+
+void tearDown() {
+}
+
+void test_render_on_change_past_hysteresis() {
+    RefreshPolicy policy(fakeClock);
+    policy.begin();
+
+    TEST_ASSERT_EQUAL_INT16(25, policy.displayTemperature(25.0F));
+    TEST_ASSERT_TRUE(policy.isComposeDue());
+    TEST_ASSERT_EQUAL(RefreshPolicy::ACTION_RENDER, policy.commit(true));
+
+    // noise inside the band keeps the displayed degree, so the frame is unchanged
+    fake_millis += RefreshPolicy::SCREEN_UPDATE_MIN_TIME;
+    TEST_ASSERT_TRUE(policy.isComposeDue());
+    TEST_ASSERT_EQUAL_INT16(25, policy.displayTemperature(26.1F));
+    TEST_ASSERT_EQUAL_INT16(25, policy.displayTemperature(24.85F));
+    TEST_ASSERT_EQUAL(RefreshPolicy::ACTION_NONE, policy.commit(false));
+
+    // past the band, a new frame is rendered but never before the minimum gap
+    TEST_ASSERT_EQUAL_INT16(26, policy.displayTemperature(26.25F));
+    fake_millis += RefreshPolicy::SCREEN_UPDATE_MIN_TIME - 1;
+    TEST_ASSERT_FALSE(policy.isComposeDue());
+    fake_millis += 1;
+    TEST_ASSERT_TRUE(policy.isComposeDue());
+    TEST_ASSERT_EQUAL(RefreshPolicy::ACTION_RENDER, policy.commit(true));
+
+    TEST_ASSERT_EQUAL_INT16(26, policy.displayTemperature(25.85F));
+    TEST_ASSERT_EQUAL_INT16(25, policy.displayTemperature(25.75F));
+}
+
+void test_repaint_backoff_doubles_up_to_max() {
+    RefreshPolicy policy(fakeClock);
+    policy.begin();
+
+    TEST_ASSERT_TRUE(policy.isComposeDue());
+    TEST_ASSERT_EQUAL(RefreshPolicy::ACTION_RENDER, policy.commit(true));
+
+    unsigned long latest_repaint = 0;
+    unsigned long since          = fake_millis;
+    unsigned long interval       = RefreshPolicy::SCREEN_REPAINT_TIME;
+
+    for (uint8_t i = 0; i < 8; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(1, idleFor(policy, interval, RefreshPolicy::SCREEN_UPDATE_MIN_TIME, &latest_repaint));
+        TEST_ASSERT_EQUAL_UINT32(since + interval, latest_repaint);
+
+        since    = latest_repaint;
+        interval = interval * 2 < RefreshPolicy::SCREEN_UPDATE_MAX_TIME ? interval * 2 : RefreshPolicy::SCREEN_UPDATE_MAX_TIME;
+        TEST_ASSERT_EQUAL_UINT32(interval, policy.getUpdateInterval());
+    }
+    TEST_ASSERT_EQUAL_UINT32(RefreshPolicy::SCREEN_UPDATE_MAX_TIME, policy.getUpdateInterval());
+
+    // a change resets the backoff
+    fake_millis += RefreshPolicy::SCREEN_UPDATE_MIN_TIME;
+    TEST_ASSERT_TRUE(policy.isComposeDue());
+    TEST_ASSERT_EQUAL(RefreshPolicy::ACTION_RENDER, policy.commit(true));
+    TEST_ASSERT_EQUAL_UINT32(RefreshPolicy::SCREEN_REPAINT_TIME, policy.getUpdateInterval());
+}
+
+void test_backlight_off_after_presence_timeout() {
+    RefreshPolicy policy(fakeClock);
+    policy.begin();
+
+    TEST_ASSERT_TRUE(policy.updatePresence(true, true));
+
+    fake_millis += RefreshPolicy::PRESENCE_TIMEOUT - 1;
+    TEST_ASSERT_TRUE(policy.updatePresence(true, false));
+
+    fake_millis += 1;
+    TEST_ASSERT_FALSE(policy.updatePresence(true, false));
+
+    // anybody back lights it again, unless the user turned it off
+    TEST_ASSERT_TRUE(policy.updatePresence(true, true));
+    TEST_ASSERT_FALSE(policy.updatePresence(false, true));
+}
+
+void test_occupied_time_restarts_after_empty_room() {
+    RefreshPolicy policy(fakeClock);
+    policy.begin();
+
+    // motion every 30s keeps the room occupied
+    for (uint8_t i = 0; i < 10; ++i) {
+        fake_millis += 30000UL;
+        policy.updatePresence(true, true);
+    }
+    TEST_ASSERT_EQUAL_UINT32(300000UL, policy.getOccupiedTime());
+
+    // somebody walks in once the room emptied
+    fake_millis += RefreshPolicy::PRESENCE_TIMEOUT;
+    TEST_ASSERT_TRUE(policy.updatePresence(true, true));
+    TEST_ASSERT_EQUAL_UINT32(0, policy.getOccupiedTime());
+}
+
+void test_millis_wraparound() {
+    fake_millis = ULONG_MAX - 999UL;
+
+    RefreshPolicy policy(fakeClock);
+    policy.begin();
+
+    TEST_ASSERT_TRUE(policy.updatePresence(true, true));
+    TEST_ASSERT_TRUE(policy.isComposeDue());
+    TEST_ASSERT_EQUAL(RefreshPolicy::ACTION_RENDER, policy.commit(true));
+
+    // first repaint lands on time while the clock wraps in between
+    unsigned long started        = fake_millis;
+    unsigned long latest_repaint = 0;
+    TEST_ASSERT_EQUAL_UINT8(1, idleFor(policy, RefreshPolicy::SCREEN_REPAINT_TIME, RefreshPolicy::SCREEN_UPDATE_MIN_TIME, &latest_repaint));
+    TEST_ASSERT_EQUAL_UINT32(started + RefreshPolicy::SCREEN_REPAINT_TIME, latest_repaint);
+    TEST_ASSERT_TRUE(fake_millis < started);
+
+    // presence timeout and uptime are measured across the wrap too
+    fake_millis = started + RefreshPolicy::PRESENCE_TIMEOUT - 1;
+    TEST_ASSERT_TRUE(policy.updatePresence(true, false));
+    fake_millis += 1;
+    TEST_ASSERT_FALSE(policy.updatePresence(true, false));
+
+    fake_millis = started + 90000UL;
+    TEST_ASSERT_EQUAL_UINT32(90, policy.getUptime());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_render_on_change_past_hysteresis);
+    RUN_TEST(test_repaint_backoff_doubles_up_to_max);
+    RUN_TEST(test_backlight_off_after_presence_timeout);
+    RUN_TEST(test_occupied_time_restarts_after_empty_room);
+    RUN_TEST(test_millis_wraparound);
+    return UNITY_END();
+}
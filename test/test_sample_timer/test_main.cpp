@@ -0,0 +1,98 @@
+#include <SampleTimer.hpp>
+#include <SleepWindow.hpp>
+#include <unity.h>
+
+static const unsigned long SAMPLE_INTERVAL = 2000UL;
+static const unsigned long CONVERSION_TIME = 750UL;
+static const uint8_t PIN_PIR               = 16;
+
+/** Simulated `millis()`, it only moves while sleeping */
+static unsigned long fake_millis = 0;
+/** Simulated PIR, it goes high at `pir_edge_ms` */
+static unsigned long pir_edge_ms = 0;
+
+static unsigned long fakeClock() {
+    return fake_millis;
+}
+
+static void fakeSleep(unsigned long ms) {
+    fake_millis += ms;
+}
+
+static int fakePinRead(uint8_t pin) {
+    return pin == PIN_PIR && fake_millis >= pir_edge_ms ? 1 : 0;
+}
+
+void setUp() {
+    fake_millis = 0;
+    pir_edge_ms = 0xFFFFFFFFUL;
+}
+
+void tearDown() {
+}
+
+void test_request_then_read_after_conversion() {
+    SampleTimer timer(fakeClock, SAMPLE_INTERVAL, CONVERSION_TIME);
+
+    TEST_ASSERT_EQUAL(SampleTimer::ACTION_NONE, timer.poll());
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_INTERVAL, timer.next());
+
+    fake_millis = SAMPLE_INTERVAL;
+    TEST_ASSERT_EQUAL(SampleTimer::ACTION_REQUEST, timer.poll());
+    TEST_ASSERT_TRUE(timer.isConverting());
+    TEST_ASSERT_EQUAL_UINT32(CONVERSION_TIME, timer.next());
+
+    fake_millis += CONVERSION_TIME - 1;
+    TEST_ASSERT_EQUAL(SampleTimer::ACTION_NONE, timer.poll());
+    fake_millis += 1;
+    TEST_ASSERT_EQUAL(SampleTimer::ACTION_READ, timer.poll());
+    TEST_ASSERT_FALSE(timer.isConverting());
+
+    // the interval counts from the request, not from the read
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_INTERVAL - CONVERSION_TIME, timer.next());
+}
+
+void test_no_sample_is_missed_while_sleeping() {
+    SampleTimer timer(fakeClock, SAMPLE_INTERVAL, CONVERSION_TIME);
+    SleepWindow window(fakeClock, fakeSleep, fakePinRead);
+    window.begin(PIN_PIR);
+
+    const unsigned long duration = 600000UL;
+    unsigned long requests       = 0;
+    unsigned long reads          = 0;
+    unsigned long due_ms         = SAMPLE_INTERVAL;
+
+    // idle loop of `main.cpp`, a PIR pulse in the middle must not shift the samples either
+    pir_edge_ms = duration / 2 + 123;
+
+    while (fake_millis < duration) {
+        switch (timer.poll()) {
+            case SampleTimer::ACTION_REQUEST:
+                TEST_ASSERT_EQUAL_UINT32(due_ms, fake_millis);
+                due_ms += CONVERSION_TIME;
+                ++requests;
+                break;
+            case SampleTimer::ACTION_READ:
+                TEST_ASSERT_EQUAL_UINT32(due_ms, fake_millis);
+                due_ms += SAMPLE_INTERVAL - CONVERSION_TIME;
+                ++reads;
+                break;
+            case SampleTimer::ACTION_NONE:
+            default:
+                break;
+        }
+
+        window.sleep(timer.next());
+    }
+
+    // the first request is at `SAMPLE_INTERVAL`
+    TEST_ASSERT_EQUAL_UINT32((duration - 1) / SAMPLE_INTERVAL, requests);
+    TEST_ASSERT_EQUAL_UINT32(requests, reads);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_request_then_read_after_conversion);
+    RUN_TEST(test_no_sample_is_missed_while_sleeping);
+    return UNITY_END();
+}
@@ -0,0 +1,73 @@
+#include <SleepWindow.hpp>
+#include <unity.h>
+
+static const uint8_t PIN_PIR = 16;
+
+/** Simulated `millis()`, it only moves while sleeping */
+static unsigned long fake_millis = 0;
+/** Simulated PIR, it goes high at `pir_edge_ms` */
+static unsigned long pir_edge_ms = 0;
+static bool has_pir_edge         = false;
+/** Longest single sleep handed to the SDK */
+static unsigned long longest_sleep = 0;
+
+static unsigned long fakeClock() {
+    return fake_millis;
+}
+
+static void fakeSleep(unsigned long ms) {
+    fake_millis += ms;
+    longest_sleep = ms > longest_sleep ? ms : longest_sleep;
+}
+
+static int fakePinRead(uint8_t pin) {
+    return pin == PIN_PIR && has_pir_edge && fake_millis >= pir_edge_ms ? 1 : 0;
+}
+
+void setUp() {
+    fake_millis   = 0;
+    pir_edge_ms   = 0;
+    has_pir_edge  = false;
+    longest_sleep = 0;
+}
+
+void tearDown() {
+}
+
+void test_pir_edge_ends_sleep_within_poll_time() {
+    SleepWindow window(fakeClock, fakeSleep, fakePinRead);
+    window.begin(PIN_PIR);
+
+    // an edge at every offset of the poll period
+    for (unsigned long offset = 1; offset <= SleepWindow::POLL_TIME; offset += 7) {
+        fake_millis  = 10000UL;
+        has_pir_edge = true;
+        pir_edge_ms  = fake_millis + 3 * SleepWindow::POLL_TIME + offset;
+
+        TEST_ASSERT_TRUE(window.sleep(SleepWindow::MAX_SLEEP_TIME));
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(SleepWindow::POLL_TIME, fake_millis - pir_edge_ms);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(SleepWindow::POLL_TIME, window.getLastWakeLatency());
+    }
+}
+
+void test_sleep_never_passes_next_task() {
+    SleepWindow window(fakeClock, fakeSleep, fakePinRead);
+    window.begin(PIN_PIR);
+
+    for (unsigned long next_task_ms = 0; next_task_ms <= 2 * SleepWindow::MAX_SLEEP_TIME; next_task_ms += 13) {
+        unsigned long start_ms = fake_millis;
+
+        TEST_ASSERT_FALSE(window.sleep(next_task_ms));
+
+        unsigned long bound = next_task_ms < SleepWindow::MAX_SLEEP_TIME ? next_task_ms : SleepWindow::MAX_SLEEP_TIME;
+        TEST_ASSERT_EQUAL_UINT32(bound, fake_millis - start_ms);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(SleepWindow::POLL_TIME, longest_sleep);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pir_edge_ends_sleep_within_poll_time);
+    RUN_TEST(test_sleep_never_passes_next_task);
+    return UNITY_END();
+}
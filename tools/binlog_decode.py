@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Decode BinLog records into text.
+
+Format strings are not sent by the device, they are read back from the
+firmware ELF at the address carried by each record.
+
+    pip install pyelftools pyserial
+    python tools/binlog_decode.py .pio/build/nodemcuv2/firmware.elf --serial /dev/ttyUSB0
+    python tools/binlog_decode.py .pio/build/nodemcuv2/firmware.elf --udp 9000
+    python tools/binlog_decode.py .pio/build/nodemcuv2/firmware.elf --file capture.bin
+"""
+
+import argparse
+import re
+import socket
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+FRAME_SYNC = b"\xa5\x5a"
+HEADER_MAGIC = 0xB1
+RECORD_WORDS = 3
+
+SPECIFIER = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z)?([diuxXocfFeEgG%])")
+
+
+class FormatTable:
+    """Resolve format string addresses from the ELF sections."""
+
+    def __init__(self, path):
+        self._sections = []
+        self._cache = {}
+
+        with open(path, "rb") as stream:
+            for section in ELFFile(stream).iter_sections():
+                if section["sh_addr"] == 0 or section["sh_type"] == "SHT_NOBITS":
+                    continue
+                self._sections.append((section["sh_addr"], section.data()))
+
+    def lookup(self, address):
+        if address not in self._cache:
+            self._cache[address] = self._read(address)
+        return self._cache[address]
+
+    def _read(self, address):
+        for base, data in self._sections:
+            if base <= address < base + len(data):
+                end = data.find(b"\0", address - base)
+                return data[address - base:end].decode("ascii", "replace")
+        return None
+
+
+def render(fmt, args):
+    """Apply a C format string to the raw 32 bits arguments."""
+    values = iter(args)
+
+    def convert(match):
+        flags, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+
+        word = next(values, 0)
+        if conversion in "di":
+            value = struct.unpack("<i", struct.pack("<I", word))[0]
+            return ("%" + flags + "d") % value
+        if conversion in "fFeEgG":
+            value = struct.unpack("<f", struct.pack("<I", word))[0]
+            return ("%" + flags + conversion) % value
+        if conversion == "c":
+            return chr(word & 0xFF)
+        return ("%" + flags + conversion) % word
+
+    return SPECIFIER.sub(convert, fmt)
+
+
+def decode(stream, formats, out):
+    """Read frames from a byte iterator and print one line per record."""
+    buffer = b""
+
+    for chunk in stream:
+        buffer += chunk
+
+        while True:
+            start = buffer.find(FRAME_SYNC)
+            if start < 0:
+                buffer = buffer[-1:]
+                break
+            buffer = buffer[start:]
+
+            if len(buffer) < 2 + 4:
+                break
+
+            header = struct.unpack_from("<I", buffer, 2)[0]
+            words = (header >> 8) & 0xFF
+            count = (header >> 16) & 0xFF
+            if header & 0xFF != HEADER_MAGIC or words != RECORD_WORDS + count:
+                # false sync inside a payload, look further
+                buffer = buffer[1:]
+                continue
+
+            size = 2 + words * 4
+            if len(buffer) < size:
+                break
+
+            record = struct.unpack_from("<%dI" % words, buffer, 2)
+            buffer = buffer[size:]
+
+            address, timestamp = record[1], record[2]
+            fmt = formats.lookup(address)
+            if fmt is None:
+                text = "<unknown format 0x%08x> %s" % (address, " ".join("0x%08x" % w for w in record[3:]))
+            else:
+                text = render(fmt, record[3:])
+
+            out.write("[%12.6f] %s\n" % (timestamp / 1e6, text))
+            out.flush()
+
+
+def read_serial(port, baud):
+    import serial
+
+    with serial.Serial(port, baud, timeout=0.1) as device:
+        while True:
+            chunk = device.read(256)
+            if chunk:
+                yield chunk
+
+
+def read_udp(port):
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as sock:
+        sock.bind(("", port))
+        while True:
+            yield sock.recv(2048)
+
+
+def read_file(path):
+    with open(path, "rb") as stream:
+        while True:
+            chunk = stream.read(4096)
+            if not chunk:
+                return
+            yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware ELF the device is running")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--serial", metavar="PORT", help="read frames from a serial port")
+    source.add_argument("--udp", metavar="PORT", type=int, help="listen for datagrams on a UDP port")
+    source.add_argument("--file", metavar="PATH", help="decode a raw capture")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    formats = FormatTable(args.elf)
+
+    if args.serial:
+        stream = read_serial(args.serial, args.baud)
+    elif args.udp:
+        stream = read_udp(args.udp)
+    else:
+        stream = read_file(args.file)
+
+    try:
+        decode(stream, formats, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()